@@ -0,0 +1,60 @@
+/**
+ * @file bench.c
+ *
+ * Host benchmarks, make bench
+ */
+
+#include "bench/bench.h"
+
+volatile uint32_t bench_sink = 0;
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+extern void BenchRun(const char* group, const char* name, uint32_t size, BenchRun_f run,
+                     void* arg)
+{
+    uint64_t best = UINT64_MAX;
+
+    // warm up caches and branch predictors
+    run(arg, BENCH_ITERATIONS);
+
+    for (int i = 0; i < BENCH_RUNS; i++)
+    {
+        // the host port counts nanoseconds
+        uint64_t start = OSGetCycles();
+
+        run(arg, BENCH_ITERATIONS);
+
+        uint64_t elapsed = OSGetCycles() - start;
+
+        best = (elapsed < best) ? elapsed : best;
+    }
+
+    printf("%-10s %-18s %5u %8.2f ns\n", group, name, size, (double)best / BENCH_ITERATIONS);
+}
+
+int main()
+{
+    KernelInit(&os, &callbacks);
+    OSTimebaseInit(OS_PORT_HOST_HZ);
+
+    printf("%-10s %-18s %5s %11s\n", "group", "name", "size", "per op");
+
+#if OS_CFG_DISPATCH
+    BenchDispatch();
+#endif
+
+#if OS_CFG_HSM && OS_CFG_STATE_MACHINE
+    BenchHsm();
+#endif
+
+#if OS_CFG_DIRECT
+    BenchDirect();
+#endif
+
+    BenchRmk();
+    BenchCopy();
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file bench.h
+ *
+ * Host benchmarks, one group per file. Times are ns per operation on the build machine, only the
+ * ratios between rows of a group carry over to a target, and only roughly.
+ */
+
+#pragma once
+
+#include "inc/os.h"
+#include "ports/host/port_host.h"
+
+#include <stdio.h>
+
+//! operations per timed run
+#define BENCH_ITERATIONS (1U << 20)
+
+//! timed runs per row, the fastest is reported
+#define BENCH_RUNS 5
+
+/**
+ * @brief Runs the operation under test iterations times
+ *
+ */
+typedef void (*BenchRun_f)(void* arg, uint32_t iterations);
+
+//! results are added here so the timed loops can't be optimised away
+extern volatile uint32_t bench_sink;
+
+/**
+ * @brief Times run and prints a row: group, name, size and ns per operation
+ *
+ * @param group
+ * @param name
+ * @param size ids, depth or bytes, whatever the group varies
+ * @param run
+ * @param arg passed to run
+ */
+extern void BenchRun(const char* group, const char* name, uint32_t size, BenchRun_f run,
+                     void* arg);
+
+/*
+ * Groups
+ */
+
+//! dispatch tables against chained ifs, see bench_dispatch.c
+extern void BenchDispatch();
+
+//! hierarchical state machine against nested commands, see bench_hsm.c
+extern void BenchHsm();
+
+//! request/response round trip, direct dispatch against queued, see bench_direct.c
+extern void BenchDirect();
+
+//! C++ layer against a C switch, see bench_rmk.cpp
+extern void BenchRmk();
+
+//! message copies against a byte loop and libc memcpy, see bench_copy.c
+extern void BenchCopy();
@@ -0,0 +1,125 @@
+/**
+ * @file bench_copy.c
+ *
+ * Message copies from 4 to 256 bytes: the byte loop os_memcpy used to be, os_memcpy, MsgCopy
+ * and libc memcpy. MsgCopy only has rows for sizes a message can have, from sizeof(Message_t)
+ * up to the 255 bytes msg_size holds.
+ */
+
+#include "bench/bench.h"
+#include "inc/os_msg.h"
+#include "inc/os_util.h"
+
+#include <string.h>
+
+#define COPY_MAX 256
+
+//! keeps the compiler from hoisting the same copy out of the loop
+#define COPY_BARRIER() __asm volatile("" ::: "memory")
+
+typedef struct CopyCase_s
+{
+    uint32_t len;
+    union
+    {
+        Message_t msg; //!< msg_size is len for MsgCopy
+        uint8_t   bytes[COPY_MAX];
+    } src __attribute__((aligned(4)));
+    uint8_t dest[COPY_MAX] __attribute__((aligned(4)));
+} CopyCase_t;
+
+static CopyCase_t copy_case;
+
+/**
+ * @brief The byte loop os_memcpy was, kept from being turned into a memcpy call
+ *
+ */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns"))) static void
+ByteCopy(void* dest, const void* src, uint32_t len)
+{
+    uint8_t*       d = (uint8_t*)dest;
+    const uint8_t* s = (const uint8_t*)src;
+
+    while (len--)
+    {
+        *d++ = *s++;
+    }
+}
+
+static void RunBytes(void* arg, uint32_t iterations)
+{
+    CopyCase_t* c = arg;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        ByteCopy(c->dest, c->src.bytes, c->len);
+        COPY_BARRIER();
+    }
+
+    bench_sink += c->dest[c->len - 1];
+}
+
+static void RunOsMemcpy(void* arg, uint32_t iterations)
+{
+    CopyCase_t* c = arg;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        os_memcpy(c->dest, c->src.bytes, c->len);
+        COPY_BARRIER();
+    }
+
+    bench_sink += c->dest[c->len - 1];
+}
+
+static void RunMsgCopy(void* arg, uint32_t iterations)
+{
+    CopyCase_t* c = arg;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        MsgCopy(c->dest, &c->src.msg);
+        COPY_BARRIER();
+    }
+
+    bench_sink += c->dest[c->len - 1];
+}
+
+static void RunMemcpy(void* arg, uint32_t iterations)
+{
+    CopyCase_t* c = arg;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        memcpy(c->dest, c->src.bytes, c->len);
+        COPY_BARRIER();
+    }
+
+    bench_sink += c->dest[c->len - 1];
+}
+
+extern void BenchCopy()
+{
+    static const uint32_t lengths[] = {4, 8, 12, 16, 20, 32, 64, 128, 256};
+
+    for (uint32_t i = 0; i < COPY_MAX; i++)
+    {
+        copy_case.src.bytes[i] = (uint8_t)i;
+    }
+
+    for (uint32_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); n++)
+    {
+        copy_case.len = lengths[n];
+
+        BenchRun("copy", "byte loop", copy_case.len, RunBytes, &copy_case);
+        BenchRun("copy", "os_memcpy", copy_case.len, RunOsMemcpy, &copy_case);
+
+        if (copy_case.len >= sizeof(Message_t) && copy_case.len <= UINT8_MAX)
+        {
+            copy_case.src.msg.msg_size = (uint8_t)copy_case.len;
+            BenchRun("copy", "MsgCopy", copy_case.len, RunMsgCopy, &copy_case);
+        }
+
+        BenchRun("copy", "memcpy", copy_case.len, RunMemcpy, &copy_case);
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ * @file bench_direct.c
+ *
+ * Request/response round trip between two AOs, with the server's direct dispatch on and off.
+ * The client posts a request, the higher priority server replies with a post back. Direct, the
+ * server runs inline in the client's post, queued, the request is copied into its queue and
+ * both go through the scheduler.
+ */
+
+#include "bench/bench.h"
+
+#if OS_CFG_DIRECT
+
+#define START_MSG_ID   1
+#define REQUEST_MSG_ID 2
+#define REPLY_MSG_ID   3
+
+ACTIVE_OBJECT_DECL(client, 4)
+ACTIVE_OBJECT_DECL(server, 4)
+
+//! round trips left in the run
+static uint32_t remaining = 0;
+
+static void Client(Message_t* msg)
+{
+    if (REPLY_MSG_ID == msg->id)
+    {
+        bench_sink += ((DataMessage_t*)msg)->data;
+    }
+
+    if (remaining)
+    {
+        DataMessage_t request = {{REQUEST_MSG_ID, sizeof(DataMessage_t)}, 0, remaining--};
+
+        MsgQueuePut(&server, &request);
+    }
+}
+
+static void Server(Message_t* msg)
+{
+    DataMessage_t reply = {{REPLY_MSG_ID, sizeof(DataMessage_t)}, 0,
+                           ((DataMessage_t*)msg)->data + 1};
+
+    MsgQueuePut(&client, &reply);
+}
+
+static void RunRoundTrips(void* arg, uint32_t iterations)
+{
+    Message_t start = {START_MSG_ID, sizeof(Message_t)};
+
+    ActiveObjectSetDirect(&server, *(bool*)arg);
+    remaining = iterations;
+
+    MsgQueuePut(&client, &start);
+    SchedulerActivateAO();
+}
+
+extern void BenchDirect()
+{
+    bool direct = true;
+    bool queued = false;
+
+    AO_INIT(client, 3, Client, 4, 0);
+    AO_INIT(server, 1, Server, 4, 1);
+
+    BenchRun("direct", "direct", sizeof(DataMessage_t), RunRoundTrips, &direct);
+    BenchRun("direct", "queued", sizeof(DataMessage_t), RunRoundTrips, &queued);
+}
+#endif // OS_CFG_DIRECT
@@ -0,0 +1,140 @@
+/**
+ * @file bench_dispatch.c
+ *
+ * Message dispatch tables against the chained ifs they replace, for 10 to 200 ids. Ids are
+ * uniformly random, a chain of compares tests half of its ids on average. The chained ifs row
+ * is what the compiler makes of the chain at the build's optimisation level, often a jump table,
+ * the last row forbids that and shows the compares.
+ */
+
+#include "bench/bench.h"
+#include "inc/os_dispatch.h"
+
+#if OS_CFG_DISPATCH
+
+//! messages cycled through, a power of 2
+#define MESSAGES 1024
+
+/*
+ * X(n) for ids n from 0 to count - 1, t is the tens prefix of IDS_10
+ */
+// clang-format off
+#define IDS_10(X, t) X(t##0) X(t##1) X(t##2) X(t##3) X(t##4) X(t##5) X(t##6) X(t##7) X(t##8) X(t##9)
+#define IDS_50(X) IDS_10(X, ) IDS_10(X, 1) IDS_10(X, 2) IDS_10(X, 3) IDS_10(X, 4)
+#define IDS_100(X) IDS_50(X) IDS_10(X, 5) IDS_10(X, 6) IDS_10(X, 7) IDS_10(X, 8) IDS_10(X, 9)
+#define IDS_200(X)                                                                                 \
+    IDS_100(X) IDS_10(X, 10) IDS_10(X, 11) IDS_10(X, 12) IDS_10(X, 13) IDS_10(X, 14)               \
+    IDS_10(X, 15) IDS_10(X, 16) IDS_10(X, 17) IDS_10(X, 18) IDS_10(X, 19)
+// clang-format on
+
+//! a handler per id, out of line like handlers in their own files
+#define HANDLER(n)                                                                                 \
+    __attribute__((noinline)) static void Handle##n(Message_t* msg)                                \
+    {                                                                                              \
+        bench_sink += (n) + msg->msg_size;                                                         \
+    }
+
+#define ENTRY(n) MSG_DISPATCH_ENTRY(0, n, Handle##n),
+
+#define BRANCH(n)                                                                                  \
+    if ((n) == msg->id)                                                                            \
+    {                                                                                              \
+        Handle##n(msg);                                                                            \
+        return;                                                                                    \
+    }
+
+//! GCC turns the chain into a jump table where it can, Compares keeps it to compares
+#define CHAINS(count, ids)                                                                         \
+    static void Chain##count(Message_t* msg)                                                       \
+    {                                                                                              \
+        ids                                                                                        \
+    }                                                                                              \
+                                                                                                   \
+    __attribute__((optimize("no-jump-tables"))) static void Compares##count(Message_t* msg)        \
+    {                                                                                              \
+        ids                                                                                        \
+    }
+
+IDS_200(HANDLER)
+
+MSG_DISPATCH_TABLE_DECL(table_10, 0, 10, NULL, IDS_10(ENTRY, ))
+MSG_DISPATCH_TABLE_DECL(table_50, 0, 50, NULL, IDS_50(ENTRY))
+MSG_DISPATCH_TABLE_DECL(table_100, 0, 100, NULL, IDS_100(ENTRY))
+MSG_DISPATCH_TABLE_DECL(table_200, 0, 200, NULL, IDS_200(ENTRY))
+
+CHAINS(10, IDS_10(BRANCH, ))
+CHAINS(50, IDS_50(BRANCH))
+CHAINS(100, IDS_100(BRANCH))
+CHAINS(200, IDS_200(BRANCH))
+
+typedef struct DispatchCase_s
+{
+    uint32_t                      ids; //!< ids handled
+    const MessageDispatchTable_t* table;
+    EventHandler_f                chain;
+    EventHandler_f                compares;
+    Message_t                     messages[MESSAGES]; //!< random ids below ids
+} DispatchCase_t;
+
+static DispatchCase_t cases[] = {
+    {10, &table_10, Chain10, Compares10},
+    {50, &table_50, Chain50, Compares50},
+    {100, &table_100, Chain100, Compares100},
+    {200, &table_200, Chain200, Compares200},
+};
+
+//! the lookup and call the kernel does for an AO with a dispatch table
+static void RunTable(void* arg, uint32_t iterations)
+{
+    DispatchCase_t* c = arg;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        Message_t*     msg = &c->messages[i & (MESSAGES - 1)];
+        EventHandler_f handler = MessageDispatchLookup(c->table, msg->id);
+
+        if (handler)
+        {
+            handler(msg);
+        }
+    }
+}
+
+static void RunChain(void* arg, uint32_t iterations)
+{
+    DispatchCase_t* c = arg;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        c->chain(&c->messages[i & (MESSAGES - 1)]);
+    }
+}
+
+static void RunCompares(void* arg, uint32_t iterations)
+{
+    DispatchCase_t* c = arg;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        c->compares(&c->messages[i & (MESSAGES - 1)]);
+    }
+}
+
+extern void BenchDispatch()
+{
+    uint32_t seed = 1;
+
+    for (uint32_t n = 0; n < sizeof(cases) / sizeof(cases[0]); n++)
+    {
+        for (uint32_t i = 0; i < MESSAGES; i++)
+        {
+            seed = seed * 1664525U + 1013904223U;
+            cases[n].messages[i] = (Message_t){(seed >> 8) % cases[n].ids, sizeof(Message_t)};
+        }
+
+        BenchRun("dispatch", "table", cases[n].ids, RunTable, &cases[n]);
+        BenchRun("dispatch", "chained ifs", cases[n].ids, RunChain, &cases[n]);
+        BenchRun("dispatch", "ifs, no jump table", cases[n].ids, RunCompares, &cases[n]);
+    }
+}
+#endif // OS_CFG_DISPATCH
@@ -0,0 +1,158 @@
+/**
+ * @file bench_hsm.c
+ *
+ * Message dispatch in a hierarchical state machine against the nested command state machines it
+ * replaces, 2 to 6 levels deep. Half of the messages are handled by the innermost state, half by
+ * the outermost one. The HSM bubbles a message up from the leaf until handled, nested commands
+ * forward every message down through each level's StateMachineStep.
+ */
+
+#include "bench/bench.h"
+#include "inc/hsm.h"
+#include "inc/state_machine.h"
+
+#if OS_CFG_HSM && OS_CFG_STATE_MACHINE
+
+#define LEAF_MSG_ID 1
+#define TOP_MSG_ID  2
+
+#define DEPTH_MIN 2
+#define DEPTH_MAX 6
+
+static Message_t messages[2] = {{LEAF_MSG_ID, sizeof(Message_t)}, {TOP_MSG_ID, sizeof(Message_t)}};
+
+/*
+ * HSM, states[0] is the top level state, states[depth - 1] the leaf
+ */
+
+static HsmState_t states[DEPTH_MAX];
+static Hsm_t      machine;
+
+static bool HsmHandle(uint32_t id, Message_t* msg)
+{
+    if (id != msg->id)
+    {
+        return false;
+    }
+
+    bench_sink += msg->msg_size;
+
+    return true;
+}
+
+static bool HsmLeaf(Hsm_t* hsm, Message_t* msg, void* instance_data)
+{
+    return HsmHandle(LEAF_MSG_ID, msg);
+}
+
+static bool HsmMiddle(Hsm_t* hsm, Message_t* msg, void* instance_data)
+{
+    return false;
+}
+
+static bool HsmTop(Hsm_t* hsm, Message_t* msg, void* instance_data)
+{
+    return HsmHandle(TOP_MSG_ID, msg);
+}
+
+static void HsmBuild(uint32_t depth)
+{
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        states[i] = (HsmState_t){
+            .parent = (0 == i) ? NULL : &states[i - 1],
+            .initial = (depth - 1 == i) ? NULL : &states[i + 1],
+            .on_Message = (depth - 1 == i) ? HsmLeaf : ((0 == i) ? HsmTop : HsmMiddle),
+        };
+    }
+
+    HsmInit(&machine, &states[0]);
+    HsmStart(&machine, NULL);
+}
+
+static void RunHsm(void* arg, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        HsmDispatch(&machine, &messages[i & 1U], NULL);
+    }
+}
+
+/*
+ * Nested commands, each level's command steps the state machine of the level below
+ */
+
+typedef struct Level_s
+{
+    Command_t       cmd;
+    StateMachine_t* inner; //!< NULL in the innermost level
+    uint32_t        handles; //!< message id this level handles, 0 for none
+} Level_t;
+
+static Level_t        levels[DEPTH_MAX];
+static StateMachine_t machines[DEPTH_MAX];
+
+static void LevelStart(Command_t* cmd, void* instance_data)
+{
+    Level_t* level = (Level_t*)cmd;
+
+    if (level->inner)
+    {
+        StateMachineStart(level->inner, instance_data);
+    }
+}
+
+static bool LevelMessage(Command_t* cmd, Message_t* msg, void* instance_data)
+{
+    Level_t* level = (Level_t*)cmd;
+
+    if (level->inner)
+    {
+        StateMachineStep(level->inner, msg, instance_data);
+    }
+
+    if (level->handles == msg->id)
+    {
+        bench_sink += msg->msg_size;
+    }
+
+    // never done, like a state waiting for its exit event
+    return false;
+}
+
+static void NestedBuild(uint32_t depth)
+{
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        levels[i] = (Level_t){
+            .cmd = {LevelStart, LevelMessage, NULL, COMMAND_ON_END_WAIT_FOR_END, NULL},
+            .inner = (depth - 1 == i) ? NULL : &machines[i + 1],
+            .handles = (depth - 1 == i) ? LEAF_MSG_ID : ((0 == i) ? TOP_MSG_ID : 0),
+        };
+
+        StateMachineInit(&machines[i], &levels[i].cmd);
+    }
+
+    StateMachineStart(&machines[0], NULL);
+}
+
+static void RunNested(void* arg, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        StateMachineStep(&machines[0], &messages[i & 1U], NULL);
+    }
+}
+
+extern void BenchHsm()
+{
+    for (uint32_t depth = DEPTH_MIN; depth <= DEPTH_MAX; depth++)
+    {
+        HsmBuild(depth);
+        NestedBuild(depth);
+
+        BenchRun("hsm", "hsm", depth, RunHsm, NULL);
+        BenchRun("hsm", "nested commands", depth, RunNested, NULL);
+    }
+}
+#endif // OS_CFG_HSM && OS_CFG_STATE_MACHINE
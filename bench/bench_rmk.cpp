@@ -0,0 +1,186 @@
+/**
+ * @file bench_rmk.cpp
+ *
+ * C++ layer against the C it replaces: the dispatcher rmk::ActiveObject registers against a C
+ * handler switching on msg->id, both called through the AO's handler pointer like the kernel
+ * does, and a post plus the scheduler run that handles it.
+ */
+
+#include "inc/rmk.hpp"
+
+#include <cstring>
+
+extern "C" {
+#include "bench/bench.h"
+}
+
+//! messages cycled through, a power of 2
+#define MESSAGES 1024
+
+#define START_MSG_ID 1
+#define STOP_MSG_ID  2
+#define SPEED_MSG_ID 3
+#define LIMIT_MSG_ID 4
+
+struct Start : rmk::Message<Start, START_MSG_ID>
+{
+};
+
+struct Stop : rmk::Message<Stop, STOP_MSG_ID>
+{
+};
+
+struct Speed : rmk::Message<Speed, SPEED_MSG_ID>
+{
+    uint32_t rpm;
+};
+
+struct Limit : rmk::Message<Limit, LIMIT_MSG_ID>
+{
+    uint32_t rpm;
+};
+
+struct Controller
+{
+    using Messages = rmk::Messages<Start, Stop, Speed, Limit>;
+
+    static void on_Message(const Start& msg)
+    {
+        bench_sink += 1;
+    }
+
+    static void on_Message(const Stop& msg)
+    {
+        bench_sink += 2;
+    }
+
+    static void on_Message(const Speed& msg)
+    {
+        bench_sink += msg.rpm;
+    }
+
+    static void on_Message(const Limit& msg)
+    {
+        bench_sink -= msg.rpm;
+    }
+};
+
+static void ControllerC(Message_t* msg)
+{
+    switch (msg->id)
+    {
+        case START_MSG_ID:
+            bench_sink += 1;
+            break;
+        case STOP_MSG_ID:
+            bench_sink += 2;
+            break;
+        case SPEED_MSG_ID:
+            bench_sink += ((DataMessage_t*)msg)->data;
+            break;
+        case LIMIT_MSG_ID:
+            bench_sink -= ((DataMessage_t*)msg)->data;
+            break;
+    }
+}
+
+static rmk::ActiveObject<Controller, 4> controller{1, 0};
+
+ACTIVE_OBJECT_DECL(controller_c, 4)
+
+//! the same random ids as typed messages and as C messages
+static MessageGeneric_t typed_messages[MESSAGES];
+static DataMessage_t    c_messages[MESSAGES];
+
+static void RunTyped(void* arg, uint32_t iterations)
+{
+    ActiveObject_t* ao = controller.get();
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        ao->handler(reinterpret_cast<Message_t*>(&typed_messages[i & (MESSAGES - 1)]));
+    }
+}
+
+static void RunSwitch(void* arg, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        controller_c.handler(&c_messages[i & (MESSAGES - 1)].base);
+    }
+}
+
+/**
+ * @brief Places a typed message in a queue slot sized buffer
+ *
+ */
+template <typename Msg>
+static void Place(MessageGeneric_t* slot, const Msg& msg)
+{
+    static_assert(sizeof(Msg) <= sizeof(MessageGeneric_t), "message exceeds a slot");
+    memcpy(slot, &msg, sizeof(Msg));
+}
+
+static void RunPost(void* arg, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        Speed speed;
+
+        speed.rpm = i;
+        controller.post(speed);
+        SchedulerActivateAO();
+    }
+}
+
+static void RunPostC(void* arg, uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        DataMessage_t speed = {{SPEED_MSG_ID, sizeof(DataMessage_t)}, 0, i};
+
+        MsgQueuePut(&controller_c, &speed);
+        SchedulerActivateAO();
+    }
+}
+
+extern "C" void BenchRmk()
+{
+    uint32_t seed = 1;
+
+    AO_INIT(controller_c, 1, ControllerC, 4, 1);
+
+    for (uint32_t i = 0; i < MESSAGES; i++)
+    {
+        seed = seed * 1664525U + 1013904223U;
+
+        uint32_t id = START_MSG_ID + (seed >> 8) % 4;
+        Speed    speed;
+        Limit    limit;
+
+        speed.rpm = i;
+        limit.rpm = i;
+        c_messages[i] = {{id, sizeof(DataMessage_t)}, 0, i};
+
+        switch (id)
+        {
+            case START_MSG_ID:
+                Place(&typed_messages[i], Start());
+                break;
+            case STOP_MSG_ID:
+                Place(&typed_messages[i], Stop());
+                break;
+            case SPEED_MSG_ID:
+                Place(&typed_messages[i], speed);
+                break;
+            case LIMIT_MSG_ID:
+                Place(&typed_messages[i], limit);
+                break;
+        }
+    }
+
+    BenchRun("rmk", "rmk dispatch", 4, RunTyped, nullptr);
+    BenchRun("rmk", "c switch", 4, RunSwitch, nullptr);
+    BenchRun("rmk", "rmk post", sizeof(Speed), RunPost, nullptr);
+    BenchRun("rmk", "c post", sizeof(DataMessage_t), RunPostC, nullptr);
+}
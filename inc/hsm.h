@@ -0,0 +1,112 @@
+/**
+ * @file hsm.h
+ */
+
+#pragma once
+
+#include "os_defs.h"
+
+typedef struct HsmState_s      HsmState_t;
+typedef struct HsmTransition_s HsmTransition_t;
+typedef struct Hsm_s           Hsm_t;
+
+/**
+ * @brief State of a hierarchical state machine. Usually declared const.
+ *
+ * Messages not handled by a state bubble up to its parent.
+ */
+struct HsmState_s
+{
+    const HsmState_t* parent; //!< enclosing state, NULL for top level states
+    const HsmState_t* initial; //!< substate entered after this state, NULL for leaf states
+    void (*on_Entry)(Hsm_t* hsm, void* instance_data); //!< may be NULL
+    void (*on_Exit)(Hsm_t* hsm, void* instance_data); //!< may be NULL
+    bool (*on_Message)(Hsm_t* hsm, Message_t* msg, void* instance_data); //!< true if handled
+};
+
+/**
+ * @brief Transition with its exit and entry paths computed once in HsmTransitionInit
+ *
+ * Transitions are external, the least common ancestor is never exited or entered.
+ * The entry path includes the initial substates below the target.
+ */
+struct HsmTransition_s
+{
+    const HsmState_t* source; //!< state the transition is defined on
+    const HsmState_t* target;
+    const HsmState_t* exit_path[HSM_MAX_DEPTH]; //!< source up to (excluding) the LCA
+    const HsmState_t* entry_path[HSM_MAX_DEPTH]; //!< below the LCA down to the target's leaf
+    uint8_t           exit_count;
+    uint8_t           entry_count;
+};
+
+/**
+ * @brief Hierarchical state machine instance data
+ */
+struct Hsm_s
+{
+    const HsmState_t*      initial; //!< top level state entered on start
+    const HsmState_t*      current; //!< current leaf state
+    const HsmTransition_t* pending; //!< transition requested by the running handler
+};
+
+/**
+ * @brief Compute and cache the exit and entry paths of a transition
+ *
+ * @param transition
+ * @param source State the transition is taken from, the state handling the message
+ * @param target
+ * @return OSStatus_t OS_INVALID_ARGUMENT if the source, or the leaf reached through the target's
+ *         initial substates, is nested deeper than HSM_MAX_DEPTH
+ */
+extern OSStatus_t HsmTransitionInit(HsmTransition_t* transition, const HsmState_t* source,
+                                    const HsmState_t* target);
+
+/**
+ * @brief Initialize state machine instance data
+ *
+ * @param hsm State machine instance
+ * @param initial First state
+ */
+extern void HsmInit(Hsm_t* hsm, const HsmState_t* initial);
+
+/**
+ * @brief Enter the initial state and its initial substates
+ *
+ * @param hsm State machine instance
+ * @param instance_data
+ * @return OSStatus_t OS_INVALID_ARGUMENT, and nothing entered, if there is no initial state or
+ *         the leaf reached from it is nested deeper than HSM_MAX_DEPTH
+ */
+extern OSStatus_t HsmStart(Hsm_t* hsm, void* instance_data);
+
+/**
+ * @brief Hand the message to the current state, bubbling up to parents until handled.
+ *        Runs the transition requested by the handler, if any.
+ *
+ * @param hsm State machine instance
+ * @param msg Current message
+ * @param instance_data
+ * @return true if some state handled the message
+ */
+extern bool HsmDispatch(Hsm_t* hsm, Message_t* msg, void* instance_data);
+
+/**
+ * @brief Request a transition, taken once the running on_Message returns.
+ *        Only valid from on_Message.
+ *
+ * @param hsm State machine instance
+ * @param transition
+ * @return OSStatus_t OS_INVALID_ARGUMENT, and no transition, if its source is neither the current
+ *         state nor one of its ancestors
+ */
+extern OSStatus_t HsmTransition(Hsm_t* hsm, const HsmTransition_t* transition);
+
+/**
+ * @brief Check if the state machine is in a state or one of its substates
+ *
+ * @param hsm State machine instance
+ * @param state
+ * @return true if state is the current state or one of its ancestors
+ */
+extern bool HsmIsIn(Hsm_t* hsm, const HsmState_t* state);
@@ -7,8 +7,10 @@
 #include "os_defs.h"
 #include "os_util.h"
 
+#include "os_dispatch.h"
 #include "os_mem.h"
 #include "os_msg.h"
+#include "os_time.h"
 
 /**
  * @brief Macro to declare an AO with a message queue and message queue buffer
@@ -24,6 +26,20 @@
     MessageQueue_t   name##_message_queue;                                                         \
     MessageGeneric_t name##_message_queue_buffer[queue_size];
 
+/**
+ * @brief Macro to declare an AO with a packed message queue of queue_bytes bytes
+ *
+ */
+#define ACTIVE_OBJECT_EXTERN_PACKED(name, queue_bytes)                                             \
+    extern ActiveObject_t name;                                                                    \
+    extern MessageQueue_t name##_message_queue;                                                    \
+    extern uint32_t       name##_message_queue_buffer[((queue_bytes) + 3) / 4];
+
+#define ACTIVE_OBJECT_DECL_PACKED(name, queue_bytes)                                               \
+    ActiveObject_t name;                                                                           \
+    MessageQueue_t name##_message_queue;                                                           \
+    uint32_t       name##_message_queue_buffer[((queue_bytes) + 3) / 4];
+
 /**
  * @brief Macro to create a message queue and active object
  *
@@ -32,6 +48,24 @@
     MsgQueueCreate(&name##_message_queue, size, name##_message_queue_buffer);                      \
     ActiveObjectCreate(&name, priority, &name##_message_queue, handler, id);
 
+/**
+ * @brief Macro to create a packed message queue and active object
+ *
+ */
+#define AO_INIT_PACKED(name, priority, handler, queue_bytes, id)                                   \
+    MsgQueueCreatePacked(&name##_message_queue, (((queue_bytes) + 3) / 4) * 4,                     \
+                         name##_message_queue_buffer);                                             \
+    ActiveObjectCreate(&name, priority, &name##_message_queue, handler, id);
+
+/**
+ * @brief Macro to create a message queue and an active object dispatching through a table
+ *
+ */
+#define AO_INIT_DISPATCH(name, priority, table, size, id)                                          \
+    MsgQueueCreate(&name##_message_queue, size, name##_message_queue_buffer);                      \
+    ActiveObjectCreate(&name, priority, &name##_message_queue, NULL, id);                          \
+    ActiveObjectSetDispatch(&name, table);
+
 /**
  * @brief State of the Active Object
  *
@@ -77,9 +111,22 @@ struct OS_s
 typedef enum TimedEventType_e
 {
     TIMED_EVENT_SINGLE_TYPE = 0, //!< run once
-    TIMED_EVENT_PERIODIC_TYPE //!< run periodically
+    TIMED_EVENT_PERIODIC_TYPE, //!< run periodically, period counted from the last dispatch
+    TIMED_EVENT_PERIODIC_ABSOLUTE_TYPE //!< run periodically at fixed release times, no drift
 } TimedEventType_t;
 
+/**
+ * @brief Release timing of an absolute periodic event
+ *
+ */
+typedef struct TimedEventTiming_s
+{
+    uint32_t releases; //!< releases dispatched
+    uint32_t overruns; //!< releases not dispatched within their period, late or skipped
+    uint32_t jitter_max; //!< largest distance between dispatch and ideal release time (ms)
+    uint32_t jitter_sum; //!< sum of distances between dispatch and ideal release time (ms)
+} TimedEventTiming_t;
+
 /**
  * @brief Simple Timed Event instance.
  *        Timed events run either once or periodically and on execution,
@@ -91,27 +138,59 @@ struct TimedEventSimple_s
     ActiveObject_t*     dest; //!< active object receiving dispatched message
     void*               message; //!< message to dispatch
     uint32_t            period; //!< delay or period of dispatch (ms)
-    uint32_t            count; //!< current count since last dispatch
+    uint32_t            count; //!< count since last dispatch, since the due time if early
+    uint32_t            slack; //!< may dispatch this early to share another event's tick (ms)
+    uint32_t            release; //!< absolute type: ideal time of the next release (ms)
     bool                active;
+    bool                skip_missed; //!< absolute type: skip releases missed entirely
     TimedEventType_t    type; //!< single or periodic
+    TimedEventTiming_t  timing; //!< absolute type: overruns and jitter
     TimedEventSimple_t* next; //!< next event in list
 };
 
+/**
+ * @brief Timed event wakeup accounting
+ *
+ */
+typedef struct TimedEventStats_s
+{
+    uint32_t wakeups; //!< ticks that dispatched at least one event
+    uint32_t dispatches; //!< events dispatched
+    uint32_t coalesced; //!< events dispatched early within their slack, wakeups saved at most
+} TimedEventStats_t;
+
 /**
  * @brief Active Object is an encapsulation for all data.
  *
  */
 struct ActiveObject_s
 {
-    MessageQueue_t*     msg_queue; //!< Incoming message queue
-    ActiveObjectState_t state; //!< current state of AO
-    EventHandler_f      handler; //!< Event/message handler
-    uint8_t             priority; //!< task priority 0-255
-    uint8_t             id;
-    ActiveObject_t*     next; //!< next AO in queue
-    ActiveObject_t*     prev; //!< prev AO in queue
+    MessageQueue_t*               msg_queue; //!< Incoming message queue
+    ActiveObjectState_t           state; //!< current state of AO
+    EventHandler_f                handler; //!< Event/message handler
+#if OS_CFG_DISPATCH
+    const MessageDispatchTable_t* dispatch; //!< per message id handlers, used instead of handler
+#endif
+    volatile uint32_t             event_flags; //!< pending flags, see ActiveObjectSetFlags
+#if OS_CFG_DIRECT
+    bool                          direct; //!< may run inline on post, see ActiveObjectSetDirect
+#endif
+#if OS_CFG_PROXY
+    ProxyLink_t*                  proxy; //!< link to the node running the AO, NULL if local
+#endif
+    uint8_t                       priority; //!< task priority 0-255
+    uint8_t                       id;
+    ActiveObject_t*               next; //!< next AO in queue
+    ActiveObject_t*               prev; //!< prev AO in queue
 };
 
+//! true if the AO is a proxy for one on another node, it has no queue, see os_proxy.h
+#if OS_CFG_PROXY
+    #define AO_IS_PROXY(ao) (NULL != (ao)->proxy)
+#else
+    #define AO_IS_PROXY(ao) false
+#endif
+
 extern OS_t* OSGetOS();
 
 /**
@@ -140,10 +219,49 @@ extern void KernelInit(OS_t* os, OSCallbacksCfg_t* callback_cfg);
 extern void ActiveObjectCreate(ActiveObject_t* ao, uint8_t priority, MessageQueue_t* queue,
                                EventHandler_f handler, uint8_t id);
 
+#if OS_CFG_DISPATCH
+/**
+ * @brief Dispatch messages through a message id table instead of a single handler
+ *
+ * @param ao
+ * @param table dispatch table, NULL to go back to ao->handler
+ */
+extern void ActiveObjectSetDispatch(ActiveObject_t* ao, const MessageDispatchTable_t* table);
+#endif
+
+#if OS_CFG_DIRECT
+/**
+ * @brief Let posts to this AO run its handler inline, on the sender's stack
+ *
+ * A post from a lower priority AO runs the handler right away with the message passed by
+ * pointer, instead of copying it into the queue, if the AO is waiting with nothing queued and
+ * nothing ready would run before it. Otherwise the message is queued as usual. Posts from ISRs
+ * and timed events are always queued. The handler still runs to completion, the sender resumes
+ * after it like after a function call, so replies posted back to the sender are queued.
+ *
+ * @param ao
+ * @param enable
+ */
+extern void ActiveObjectSetDirect(ActiveObject_t* ao, bool enable);
+#endif
+
+/**
+ * @brief Set event flags on an AO, ISR safe. Doesn't use the message queue.
+ *
+ * Flags are ORed into the AO's flag word. The AO gets a single EventFlagsMessage_t
+ * (id OS_EVENT_FLAGS_MSG_ID) with every flag set since the last one, after its queued messages.
+ *
+ * @param ao
+ * @param flags bits to set
+ * @return OSStatus_t OS_INVALID_ARGUMENT for a proxy, it has nowhere to keep flags
+ */
+extern OSStatus_t ActiveObjectSetFlags(ActiveObject_t* ao, uint32_t flags);
+
 /**
  * @brief Start the scheduler, does not return.
  *
- * If nothing is currently running, enters idle loop
+ * If nothing is currently running, enters idle loop, running a slice of background jobs
+ * (see os_job.h) and the on_Idle hook
  *
  */
 extern void SchedulerRun();
@@ -155,6 +273,31 @@ extern void SchedulerRun();
  */
 extern int Schedule();
 
+/**
+ * @brief Check if any AO or deferred call is ready or running
+ *
+ * @return true if the scheduler has work
+ */
+extern bool SchedulerHasReady();
+
+/**
+ * @brief AO whose handler is running, ISRs see the AO they interrupted
+ *
+ * @return ActiveObject_t* NULL outside AOs
+ */
+extern ActiveObject_t* SchedulerGetCurrentAO();
+
+#if OS_CFG_DIRECT
+/**
+ * @brief Used by MsgQueuePut, runs the handler of a direct AO inline if possible
+ *
+ * @param ao
+ * @param msg
+ * @return true if the message has been handled, false if it must be queued
+ */
+extern bool SchedulerDispatchDirect(ActiveObject_t* ao, Message_t* msg);
+#endif
+
 /**
  * @brief Activates the first active object in queue
  *
@@ -168,6 +311,7 @@ extern void SchedulerActivateAO();
  */
 extern void SchedulerAddReady(ActiveObject_t* ao);
 
+#if OS_CFG_TIMED_EVENTS
 /**
  * @brief Creates a simple time event
  *
@@ -180,6 +324,45 @@ extern void SchedulerAddReady(ActiveObject_t* ao);
 extern void TimedEventSimpleCreate(TimedEventSimple_t* event, ActiveObject_t* dest, void* msg,
                                    uint32_t period, TimedEventType_t type);
 
+/**
+ * @brief Creates a periodic event released at fixed times, first release one period after
+ *        it is scheduled
+ *
+ * Each release is scheduled from the previous ideal release time, not from when it was
+ * dispatched, so late dispatches (full queue, busy system) don't shift the phase.
+ * Releases missed entirely are either dispatched back to back, one per tick, or skipped.
+ *
+ * Each release not dispatched within its period counts once in timing.overruns. Catching up,
+ * that is a release dispatched a period or more late. Skipping, the late dispatch stands for
+ * the latest release due and counts as on time, with jitter measured from that release, and
+ * the releases before it count as skipped. A release exactly one period late is one overrun
+ * either way.
+ *
+ * @param event
+ * @param dest
+ * @param msg
+ * @param period (ms)
+ * @param skip_missed true to skip releases missed entirely, false to catch up
+ */
+extern void TimedEventAbsoluteCreate(TimedEventSimple_t* event, ActiveObject_t* dest, void* msg,
+                                     uint32_t period, bool skip_missed);
+
+/**
+ * @brief Lets the event dispatch up to slack ms early when another event is due,
+ *        so both are handled in one wakeup. The next period still starts at the due time
+ *
+ * @param event
+ * @param slack (ms), 0 by default
+ */
+extern void TimedEventSetSlack(TimedEventSimple_t* event, uint32_t slack);
+
+/**
+ * @brief Copies the timed event wakeup accounting
+ *
+ * @param stats
+ */
+extern void SchedulerGetTimedEventStats(TimedEventStats_t* stats);
+
 /**
  * @brief Disable the event and remove it from the queue
  */
@@ -191,3 +374,4 @@ extern void TimedEventDisable(TimedEventSimple_t* event);
  * @param event
  */
 extern void SchedulerAddTimedEvent(TimedEventSimple_t* event);
+#endif
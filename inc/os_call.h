@@ -0,0 +1,114 @@
+/**
+ * @file os_call.h
+ */
+
+#pragma once
+
+#include "os.h"
+
+//! never returned for a successful request
+#define OS_CALL_TOKEN_NONE 0U
+
+//! end of the free slot list
+#define OS_CALL_SLOT_NONE 0xFF
+
+typedef uint32_t             CallToken_t;
+typedef struct CallMessage_s CallMessage_t;
+
+/**
+ * @brief Base of request and reply messages, also the timeout message
+ *
+ * Requests and replies embed it as their first member, like Message_t in other messages.
+ *
+ * @code
+ * typedef struct ReadRequest_s
+ * {
+ *     CallMessage_t call;
+ *     uint16_t      address;
+ * } ReadRequest_t;
+ * @endcode
+ */
+struct CallMessage_s
+{
+    Message_t   base;
+    CallToken_t token; //!< correlates the request, its reply and its timeout
+};
+
+/**
+ * @brief Pending call, slot of the call table
+ *
+ */
+typedef struct CallSlot_s
+{
+    ActiveObject_t* caller; //!< gets the reply or the timeout
+    uint32_t        deadline; //!< OS time the call times out at (ms)
+    uint16_t        generation; //!< upper part of the token, invalidates stale tokens
+    uint8_t         next_free; //!< free list link
+    bool            pending;
+    bool            has_timeout;
+} CallSlot_t;
+
+#if OS_CFG_CALL
+/**
+ * @brief Initializes the call table, called by KernelInit
+ *
+ */
+extern void OSCallInit();
+
+/**
+ * @brief Posts a request and registers it as a pending call
+ *
+ * The token is written to request->token before posting, so the callee copies it into its
+ * reply. The caller gets either the reply or a CallMessage_t with id OS_CALL_TIMEOUT_MSG_ID
+ * carrying the same token, never both.
+ *
+ * @param caller AO receiving the reply or the timeout
+ * @param callee AO handling the request
+ * @param request
+ * @param timeout_ms 0 to wait forever
+ * @return CallToken_t OS_CALL_TOKEN_NONE if the table or the callee's queue is full
+ */
+extern CallToken_t OSCallRequest(ActiveObject_t* caller, ActiveObject_t* callee,
+                                 CallMessage_t* request, uint32_t timeout_ms);
+
+/**
+ * @brief Posts the reply to a request to its caller and completes the call
+ *
+ * @param request Request being answered, only its token is used
+ * @param reply
+ * @return OSStatus_t OS_INVALID_ARGUMENT if the call has already timed out or been cancelled,
+ *         OS_ERROR if the caller's queue is full
+ */
+extern OSStatus_t OSCallReply(const CallMessage_t* request, CallMessage_t* reply);
+
+/**
+ * @brief Drops a pending call, a late reply is then rejected by OSCallReply
+ *
+ * @param token
+ * @return true if the call was pending
+ */
+extern bool OSCallCancel(CallToken_t token);
+
+/**
+ * @brief Check if a call is still waiting for its reply
+ *
+ * @param token
+ * @return true if pending
+ */
+extern bool OSCallIsPending(CallToken_t token);
+
+/**
+ * @brief Posts timeout messages for expired calls, called by the system tick
+ *
+ */
+extern void OSCallProcessTimeouts();
+#else
+// left out, nothing to do in KernelInit and on the system tick
+static inline void OSCallInit()
+{
+}
+
+static inline void OSCallProcessTimeouts()
+{
+}
+#endif
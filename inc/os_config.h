@@ -0,0 +1,168 @@
+/**
+ * @file os_config.h
+ *
+ * Compile time configuration of the kernel. Every setting has a default below and can be
+ * overridden with a -D flag (see the OS_CFG_* options in CMakeLists.txt) or in a project header
+ * named by OS_CONFIG_FILE, e.g. -DOS_CONFIG_FILE=\"app_os_config.h\".
+ *
+ * Subsystems set to 0 compile to nothing, their kernel hooks are removed from the hot paths.
+ */
+
+#pragma once
+
+#ifdef OS_CONFIG_FILE
+    #include OS_CONFIG_FILE
+#endif
+
+/*
+ * Hooks, 0 removes the callback and its NULL check from the kernel
+ */
+
+//! on_Init at the end of KernelInit
+#ifndef OS_CFG_HOOK_INIT
+    #define OS_CFG_HOOK_INIT 1
+#endif
+
+//! on_Idle in the scheduler idle loop
+#ifndef OS_CFG_HOOK_IDLE
+    #define OS_CFG_HOOK_IDLE 1
+#endif
+
+//! on_SysTick at the end of SysTick_Handler
+#ifndef OS_CFG_HOOK_SYSTICK
+    #define OS_CFG_HOOK_SYSTICK 1
+#endif
+
+/*
+ * Subsystems, 1 to compile in, 0 to leave out
+ */
+
+//! TimedEventSimpleCreate, SchedulerAddTimedEvent, ... processed on SysTick
+#ifndef OS_CFG_TIMED_EVENTS
+    #define OS_CFG_TIMED_EVENTS 1
+#endif
+
+//! message dispatch tables, ActiveObjectSetDispatch
+#ifndef OS_CFG_DISPATCH
+    #define OS_CFG_DISPATCH 1
+#endif
+
+//! direct dispatch on the sender's stack, ActiveObjectSetDirect
+#ifndef OS_CFG_DIRECT
+    #define OS_CFG_DIRECT 1
+#endif
+
+//! deferred function calls, os_defer.h
+#ifndef OS_CFG_DEFER
+    #define OS_CFG_DEFER 1
+#endif
+
+//! asynchronous calls between AOs, os_call.h
+#ifndef OS_CFG_CALL
+    #define OS_CFG_CALL 1
+#endif
+
+//! idle time background jobs, os_job.h
+#ifndef OS_CFG_JOB
+    #define OS_CFG_JOB 1
+#endif
+
+//! proxy AOs for other nodes, os_proxy.h
+#ifndef OS_CFG_PROXY
+    #define OS_CFG_PROXY 1
+#endif
+
+//! memory block pool, os_mem.h
+#ifndef OS_CFG_MEM
+    #define OS_CFG_MEM 1
+#endif
+
+//! command based state machines, state_machine.h
+#ifndef OS_CFG_STATE_MACHINE
+    #define OS_CFG_STATE_MACHINE 1
+#endif
+
+//! hierarchical state machines, hsm.h
+#ifndef OS_CFG_HSM
+    #define OS_CFG_HSM 1
+#endif
+
+//! stackless coroutines, os_coro.h
+#ifndef OS_CFG_CORO
+    #define OS_CFG_CORO 1
+#endif
+
+//! seqlock shared state, os_shared.h
+#ifndef OS_CFG_SHARED
+    #define OS_CFG_SHARED 1
+#endif
+
+//! byte streams, os_stream.h
+#ifndef OS_CFG_STREAM
+    #define OS_CFG_STREAM 1
+#endif
+
+//! traffic record and replay, os_record.h. Recording also needs OS_RECORD_ENABLED
+#ifndef OS_CFG_RECORD
+    #define OS_CFG_RECORD 1
+#endif
+
+//! high resolution timers, HrTimerStart. Off by default, the board support has to provide
+//! OSPortHrTimerSet/OSPortHrTimerCancel on a spare hardware timer
+#ifndef OS_CFG_HRTIMER
+    #define OS_CFG_HRTIMER 0
+#endif
+
+/*
+ * Sizes
+ */
+
+//! largest message, bounds queue slots and MessageGeneric_t
+#ifndef OS_MESSAGE_MAX_SIZE
+    #define OS_MESSAGE_MAX_SIZE 20
+#endif
+
+//! bytes in the memory block pool, a multiple of 32 up to 2048
+#ifndef OS_MEM_POOL_SIZE
+    #define OS_MEM_POOL_SIZE 512
+#endif
+
+//! number of calls that can be pending at once, at most 255
+#ifndef OS_CALL_TABLE_SIZE
+    #define OS_CALL_TABLE_SIZE 16
+#endif
+
+//! deferred calls that can be pending at once, at most 255
+#ifndef OS_DEFER_POOL_SIZE
+    #define OS_DEFER_POOL_SIZE 16
+#endif
+
+//! maximum nesting depth of states, bounds the cached transition paths
+#ifndef HSM_MAX_DEPTH
+    #define HSM_MAX_DEPTH 8
+#endif
+
+//! AOs notified on publish per shared state
+#ifndef SHARED_STATE_MAX_SUBSCRIBERS
+    #define SHARED_STATE_MAX_SUBSCRIBERS 4
+#endif
+
+/*
+ * Dependencies
+ */
+
+#if OS_CFG_PROXY && !OS_CFG_DEFER
+    #error "OS_CFG_PROXY needs OS_CFG_DEFER, frames are flushed by a deferred call"
+#endif
+
+#if OS_CFG_CORO && !OS_CFG_TIMED_EVENTS
+    #error "OS_CFG_CORO needs OS_CFG_TIMED_EVENTS for await timeouts"
+#endif
+
+#if OS_CFG_RECORD && !OS_CFG_STREAM
+    #error "OS_CFG_RECORD needs OS_CFG_STREAM, records are written to a stream"
+#endif
+
+#if defined(OS_RECORD_ENABLED) && !OS_CFG_RECORD
+    #error "OS_RECORD_ENABLED needs OS_CFG_RECORD"
+#endif
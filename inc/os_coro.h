@@ -0,0 +1,184 @@
+/**
+ * @file os_coro.h
+ */
+
+#pragma once
+
+#include "os.h"
+
+//! resume point of a finished coroutine
+#define CORO_LINE_DONE 0xFFFF
+
+//! wait id that no message matches, used for plain delays
+#define CORO_WAIT_NONE 0xFFFFFFFFU
+
+typedef struct Coroutine_s      Coroutine_t;
+typedef struct CoroutineTimer_s CoroutineTimer_t;
+
+/**
+ * @brief Stackless coroutine state, resumed by the owning AO's handler
+ *
+ * The coroutine body is a function `void Body(Coroutine_t* co, Message_t* msg)` written between
+ * CORO_BEGIN and CORO_END. Each await returns from the body, the next message handed to it resumes
+ * right after the await. Locals do not survive an await, keep state in statics or a struct.
+ *
+ * Restrictions of the protothread style:
+ * - no `switch` in the body, CORO_BEGIN is one and the awaits are its case labels
+ * - the resume point is the 16-bit `__LINE__` of the await, bodies must sit below line 0xFFFF
+ * - awaits only in the body itself, not in functions it calls
+ *
+ * @code
+ * static CoroutineTimer_t timer;
+ * static Coroutine_t      co;
+ *
+ * static void Sequence(Coroutine_t* co, Message_t* msg)
+ * {
+ *     CORO_BEGIN(co);
+ *
+ *     MsgQueuePut(&radio, &request);
+ *     CORO_AWAIT_MSG_TIMEOUT(co, msg, ACK_MSG_ID, 100);
+ *
+ *     if (CORO_TIMED_OUT(co))
+ *     {
+ *         // retry, report, ...
+ *     }
+ *
+ *     CORO_DELAY(co, msg, 20);
+ *     MsgQueuePut(&radio, &next_request);
+ *
+ *     CORO_END(co);
+ * }
+ *
+ * CORO_EVENT_HANDLER(SequenceHandler, co, Sequence)
+ * @endcode
+ */
+struct Coroutine_s
+{
+    uint16_t          line; //!< resume point, 0 before start
+    bool              timed_out; //!< last await ended with a timeout
+    uint32_t          wait_id; //!< message id awaited
+    CoroutineTimer_t* timer; //!< runs the timeouts, may be shared with other coroutines
+};
+
+/**
+ * @brief Timeouts of the coroutines of one AO
+ *
+ * One timer serves any number of coroutines as long as at most one of them waits with a timeout at
+ * a time, a second timeout replaces the pending one. Coroutines that wait with timeouts at the same
+ * time need a timer each.
+ */
+struct CoroutineTimer_s
+{
+    TimedEventSimple_t event;
+    DataMessage_t      timeout_msg; //!< data carries the generation
+    Coroutine_t*       owner; //!< coroutine whose timeout is pending, NULL if none
+    uint32_t           generation; //!< counts timeouts started, stale queued ones don't match
+};
+
+/**
+ * @brief Start of the coroutine body
+ */
+#define CORO_BEGIN(co)                                                                             \
+    switch ((co)->line)                                                                            \
+    {                                                                                              \
+        case 0:
+
+/**
+ * @brief End of the coroutine body, messages are ignored until CoroutineReset
+ */
+#define CORO_END(co)                                                                               \
+    (co)->line = CORO_LINE_DONE;                                                                   \
+    default:                                                                                       \
+        break;                                                                                     \
+    }
+
+/**
+ * @brief Suspend until a message with msg_id arrives or timeout_ms pass (0 waits forever)
+ */
+#define CORO_AWAIT_MSG_TIMEOUT(co, msg, msg_id, timeout_ms)                                        \
+    do                                                                                             \
+    {                                                                                              \
+        CoroutineWait((co), (msg_id), (timeout_ms));                                               \
+        (co)->line = __LINE__;                                                                     \
+        return;                                                                                    \
+        case __LINE__:                                                                             \
+            if (!CoroutineWaitDone((co), (msg)))                                                   \
+            {                                                                                      \
+                return;                                                                            \
+            }                                                                                      \
+    } while (0)
+
+/**
+ * @brief Suspend until a message with msg_id arrives
+ */
+#define CORO_AWAIT_MSG(co, msg, msg_id) CORO_AWAIT_MSG_TIMEOUT(co, msg, msg_id, 0)
+
+/**
+ * @brief Suspend for delay_ms, other messages are ignored meanwhile
+ */
+#define CORO_DELAY(co, msg, delay_ms) CORO_AWAIT_MSG_TIMEOUT(co, msg, CORO_WAIT_NONE, delay_ms)
+
+/**
+ * @brief True if the last await ended because of its timeout
+ */
+#define CORO_TIMED_OUT(co) ((co)->timed_out)
+
+/**
+ * @brief Declares an EventHandler_f running the coroutine body on every message
+ */
+#define CORO_EVENT_HANDLER(handler, co, body)                                                      \
+    static void handler(Message_t* msg)                                                            \
+    {                                                                                              \
+        body(&(co), msg);                                                                          \
+    }
+
+/**
+ * @brief Initialize a timer for the coroutines of an AO
+ *
+ * @param timer
+ * @param ao AO running the coroutines, timeouts are posted to it
+ * @param timeout_msg_id Id used for timeout messages, must not be used by other messages
+ */
+extern void CoroutineTimerInit(CoroutineTimer_t* timer, ActiveObject_t* ao,
+                               uint32_t timeout_msg_id);
+
+/**
+ * @brief Initialize coroutine state
+ *
+ * @param co
+ * @param timer Initialized timer of the AO running the coroutine
+ */
+extern void CoroutineInit(Coroutine_t* co, CoroutineTimer_t* timer);
+
+/**
+ * @brief Restart the coroutine from CORO_BEGIN on the next message, cancels pending timeouts
+ *
+ * @param co
+ */
+extern void CoroutineReset(Coroutine_t* co);
+
+/**
+ * @brief Check if the coroutine has reached CORO_END
+ *
+ * @param co
+ * @return true if done
+ */
+extern bool CoroutineIsDone(Coroutine_t* co);
+
+/**
+ * @brief Used by the await macros, sets up what the coroutine waits for
+ *
+ * @param co
+ * @param wait_id Message id to wait for, CORO_WAIT_NONE for none
+ * @param timeout_ms 0 for no timeout
+ */
+extern void CoroutineWait(Coroutine_t* co, uint32_t wait_id, uint32_t timeout_ms);
+
+/**
+ * @brief Used by the await macros, checks if msg ends the current wait
+ *
+ * @param co
+ * @param msg
+ * @return true if the coroutine should resume
+ */
+extern bool CoroutineWaitDone(Coroutine_t* co, Message_t* msg);
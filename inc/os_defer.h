@@ -0,0 +1,91 @@
+/**
+ * @file os_defer.h
+ */
+
+#pragma once
+
+#include "os_defs.h"
+
+//! end of a deferred call list, also "no pending call" priority
+#define OS_DEFER_NONE 0xFF
+
+/**
+ * @brief Function run by a deferred call
+ *
+ */
+typedef void (*DeferredCall_f)(void* arg);
+
+/**
+ * @brief Pending deferred call, pool entry
+ *
+ */
+typedef struct DeferredCall_s
+{
+    DeferredCall_f fn;
+    void*          arg;
+    uint8_t        priority; //!< same scale as AO priorities, 0-254
+    uint8_t        next; //!< list link
+} DeferredCall_t;
+
+#if OS_CFG_DEFER
+/**
+ * @brief Initializes the deferred call pool, called by KernelInit
+ *
+ */
+extern void DeferInit();
+
+/**
+ * @brief Run fn(arg) from the scheduler at an AO priority, ISR safe
+ *
+ * Bottom half of an ISR without an AO or a message: the call runs once every AO and deferred
+ * call of higher priority is done, before ready AOs of the same or lower priority. Like an AO
+ * it doesn't preempt and isn't preempted.
+ *
+ * @param fn
+ * @param arg
+ * @param priority 0-254, OS_DEFER_NONE (255) is reserved for "no pending call"
+ * @return OSStatus_t OS_INVALID_ARGUMENT for priority OS_DEFER_NONE, OS_MEMORY_BLOCK_FULL if
+ *         OS_DEFER_POOL_SIZE calls are pending
+ */
+extern OSStatus_t DeferCall(DeferredCall_f fn, void* arg, uint8_t priority);
+
+/**
+ * @brief Priority of the next deferred call
+ *
+ * @return uint8_t OS_DEFER_NONE if none is pending
+ */
+extern uint8_t DeferHighestPriority();
+
+/**
+ * @brief Used by the scheduler, takes the next call if its priority is limit or higher
+ *
+ * @param limit
+ * @param call copy of the call
+ * @return true if a call was taken
+ */
+extern bool DeferTake(uint8_t limit, DeferredCall_t* call);
+
+/**
+ * @brief Calls rejected because the pool was full
+ *
+ * @return uint32_t
+ */
+extern uint32_t DeferDropped();
+#else
+// left out, the scheduler's checks fold away
+static inline void DeferInit()
+{
+}
+
+static inline uint8_t DeferHighestPriority()
+{
+    return OS_DEFER_NONE;
+}
+
+static inline bool DeferTake(uint8_t limit, DeferredCall_t* call)
+{
+    UNUSED(limit);
+    UNUSED(call);
+    return false;
+}
+#endif
@@ -8,6 +8,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "os_config.h"
+
 #ifdef OS_TRACE_ENABLED
     #define DEBUG_PRINT_IS_QUEUE  1
     #define DEBUG_PRINT_IS_HANDLE 0
@@ -21,13 +23,45 @@
 #define OS_MEMORY_BLOCK_FULL 2
 #define OS_ERROR             3
 
-#define OS_MESSAGE_MAX_SIZE 20
-#define OS_EVENT_LOG_MSG_ID 999
+#define OS_EVENT_LOG_MSG_ID    999
+#define OS_EVENT_FLAGS_MSG_ID  1000
+#define OS_CALL_TIMEOUT_MSG_ID 1001
 
 // clang-format off
+#ifdef OS_PORT_HOST
+// host port for tests and benchmarks, see ports/host/port_host.h
+extern void OSPortHostInterruptsEnable();
+extern void OSPortHostInterruptsDisable();
+extern void OSPortHostPendScheduler();
+
+extern uint32_t OSPortHostInterruptsSave();
+extern void OSPortHostInterruptsRestore(uint32_t state);
+
+#define ENABLE_INTERRUPTS() OSPortHostInterruptsEnable();
+#define DISABLE_INTERRUPTS() OSPortHostInterruptsDisable();
+#define CRITICAL_SECTION_ENTER(state) (state) = OSPortHostInterruptsSave();
+#define CRITICAL_SECTION_EXIT(state) OSPortHostInterruptsRestore(state);
+
+//! nothing to flush on the host, the compiler still mustn't move memory accesses across it
+#define ERRATUM() __asm volatile("" ::: "memory")
+
+//! runs SchedulerActivateAO once no ISR is active, the host's PendSV
+#define OS_PEND_SCHEDULER() OSPortHostPendScheduler()
+
+//! exception handler attribute
+#define OS_INTERRUPT
+#else
 #define ENABLE_INTERRUPTS() __asm volatile ("cpsie i" ::: "memory");
 #define DISABLE_INTERRUPTS() __asm volatile ("cpsid i" ::: "memory");
 
+/**
+ * @brief Critical section that can be entered with interrupts already disabled, EXIT restores
+ *  the PRIMASK that ENTER found instead of enabling interrupts. state is a uint32_t
+ */
+#define CRITICAL_SECTION_ENTER(state)                                                              \
+    __asm volatile ("mrs %0, primask\n cpsid i" : "=r" (state) :: "memory");
+#define CRITICAL_SECTION_EXIT(state) __asm volatile ("msr primask, %0" :: "r" (state) : "memory");
+
 /**
  * @brief see ARM errata 838869, a store immediate with offset at the end of an ISR could
  *  lead to incorrect interrupt handling. DSB is like a "flush" for pending data that needs
@@ -35,6 +69,13 @@
  */
 #define ERRATUM() __asm volatile("dsb" ::: "memory")
 
+//! sets PendSV pending, it runs SchedulerActivateAO once no other exception is active
+#define OS_PEND_SCHEDULER() *((uint32_t*)(0xE000ED04U)) = (1U << 28U)
+
+//! exception handler attribute
+#define OS_INTERRUPT __attribute__((__interrupt__))
+#endif
+
 // clang-format on
 
 #ifndef UNUSED
@@ -72,7 +113,7 @@
         DISABLE_INTERRUPTS();                                                                      \
         if (0U != Schedule())                                                                      \
         {                                                                                          \
-            *((uint32_t*)(0xE000ED04U)) = (1U << 28U);                                             \
+            OS_PEND_SCHEDULER();                                                                   \
         }                                                                                          \
         ENABLE_INTERRUPTS();                                                                       \
         ERRATUM();                                                                                 \
@@ -94,6 +135,7 @@ typedef struct MessageGeneric_s     MessageGeneric_t;
 typedef struct Message_s            Message_t;
 typedef struct DataMessage_s        DataMessage_t;
 typedef struct MemoryBlockMessage_s MemoryBlockMessage_t;
+typedef struct EventFlagsMessage_s  EventFlagsMessage_t;
 
 //! see os.h
 typedef struct ActiveObject_s ActiveObject_t;
@@ -101,6 +143,12 @@ typedef struct ActiveObject_s ActiveObject_t;
 //! see os.h
 typedef struct TimedEventSimple_s TimedEventSimple_t;
 
+//! see os_proxy.h
+typedef struct ProxyLink_s ProxyLink_t;
+
+//! see os_dispatch.h
+typedef struct MessageDispatchTable_s MessageDispatchTable_t;
+
 /**
  * @brief Event handler. Must run to completion. No blocking allowed!! Should run quickly
  *
@@ -0,0 +1,71 @@
+/**
+ * @file os_dispatch.h
+ */
+
+#pragma once
+
+#include "os_defs.h"
+
+/**
+ * @brief Macro to declare a constant, dense message dispatch table
+ *
+ * Handlers are placed with MSG_DISPATCH_ENTRY so the table is indexed directly
+ * by (id - base_id). Unlisted ids in the range are NULL and go to the default handler.
+ *
+ * @code
+ * MSG_DISPATCH_TABLE_DECL(ctl_dispatch, APP_MSG_BASE, APP_MSG_COUNT, CtlDefault,
+ *                         MSG_DISPATCH_ENTRY(APP_MSG_BASE, START_MSG_ID, CtlOnStart),
+ *                         MSG_DISPATCH_ENTRY(APP_MSG_BASE, STOP_MSG_ID, CtlOnStop))
+ * @endcode
+ */
+#define MSG_DISPATCH_TABLE_DECL(name, base_id, count, default_handler, ...)                        \
+    static const EventHandler_f  name##_handlers[(count)] = {__VA_ARGS__};                         \
+    const MessageDispatchTable_t name = {name##_handlers, (base_id), (count), (default_handler)};
+
+/**
+ * @brief Places a handler at its slot in a dispatch table initializer
+ */
+#define MSG_DISPATCH_ENTRY(base_id, msg_id, handler) [(msg_id) - (base_id)] = (handler)
+
+/**
+ * @brief Dense message id -> handler table
+ *
+ */
+struct MessageDispatchTable_s
+{
+    const EventHandler_f* handlers; //!< indexed by (id - base_id)
+    uint32_t              base_id; //!< lowest id in the table
+    uint32_t              count; //!< number of entries in handlers
+    EventHandler_f        default_handler; //!< ids outside the table or without entry, may be NULL
+};
+
+/**
+ * @brief Find the handler for a message id
+ *
+ * Single bounds check and indexed load, ids below base_id wrap around and fail the bounds check
+ *
+ * @param table
+ * @param id
+ * @return EventHandler_f handler for id, default handler if none, may be NULL
+ */
+static inline EventHandler_f MessageDispatchLookup(const MessageDispatchTable_t* table,
+                                                   uint32_t                      id)
+{
+    uint32_t index = id - table->base_id;
+
+    if (index < table->count && table->handlers[index])
+    {
+        return table->handlers[index];
+    }
+
+    return table->default_handler;
+}
+
+/**
+ * @brief Calls the handler registered for the message
+ *
+ * @param table
+ * @param msg
+ * @return true if a handler (including the default one) ran
+ */
+extern bool MessageDispatch(const MessageDispatchTable_t* table, Message_t* msg);
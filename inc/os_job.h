@@ -0,0 +1,101 @@
+/**
+ * @file os_job.h
+ */
+
+#pragma once
+
+#include "os.h"
+
+typedef struct Job_s      Job_t;
+typedef struct JobStats_s JobStats_t;
+
+/**
+ * @brief One increment of a background job, should take well below the job's slice
+ *
+ * @param job progress and total may be updated for reporting
+ * @param arg
+ * @return true when the job is complete
+ */
+typedef bool (*JobStep_f)(Job_t* job, void* arg);
+
+/**
+ * @brief Resumable background job, run in the idle loop
+ *
+ */
+struct Job_s
+{
+    JobStep_f step;
+    void*     arg;
+    uint32_t  slice_us; //!< target run time before yielding to the next job
+    uint32_t  progress; //!< work done, in units of the job's choice, set by step
+    uint32_t  total; //!< work to do, same units, set by step or before start
+    uint32_t  steps; //!< steps run
+    uint64_t  cycles; //!< time spent in steps, includes interrupts and AOs preempting them
+    uint64_t  started; //!< cycle count at JobStart
+    bool      active; //!< false once complete or cancelled
+    Job_t*    next;
+};
+
+/**
+ * @brief Job statistics
+ *
+ */
+struct JobStats_s
+{
+    uint32_t steps;
+    uint32_t progress_permille; //!< progress / total
+    uint32_t cpu_permille; //!< share of the time since JobStart spent in steps, see JobGetStats
+};
+
+#if OS_CFG_JOB
+/**
+ * @brief Add a job to the idle loop, AO or idle context
+ *
+ * Jobs take turns, each runs steps until its slice is used, it completes or an AO is ready.
+ *
+ * @param job
+ * @param step
+ * @param arg
+ * @param slice_us
+ */
+extern void JobStart(Job_t* job, JobStep_f step, void* arg, uint32_t slice_us);
+
+/**
+ * @brief Stop a job, it is removed before its next step
+ *
+ * @param job
+ */
+extern void JobCancel(Job_t* job);
+
+/**
+ * @brief Check if any job is waiting to run, the idle hook should only sleep if not
+ *
+ * @return true if jobs are pending
+ */
+extern bool JobsPending();
+
+/**
+ * @brief Used by SchedulerRun, runs one slice of the next job
+ *
+ * @return true if a job ran
+ */
+extern bool JobRunIdle();
+
+/**
+ * @brief Get job progress and CPU share
+ *
+ * Steps are timed by the cycle counter from their start to their end, so interrupts and AOs
+ * preempting a step count as the job's time. Under load cpu_permille is an upper bound of the
+ * CPU the job itself used.
+ *
+ * @param job
+ * @param stats
+ */
+extern void JobGetStats(Job_t* job, JobStats_t* stats);
+#else
+// left out, the idle loop only runs on_Idle
+static inline bool JobRunIdle()
+{
+    return false;
+}
+#endif
@@ -11,14 +11,23 @@
 #define MEMORY_BLOCK_128 128
 #define MEMORY_BLOCK_256 256
 
+//! never a valid key, set by OSMemoryBlockNew on failure
+#define OS_MEM_KEY_NONE 0U
+
 typedef uint32_t BlockSize_t;
 
 /**
- * @brief Get a key to a block of pre-allocated memory
+ * @brief Get a key to a block of pre-allocated memory, lock-free and ISR safe
+ *
+ * Keys are generation << 8 | size class << 6 | index. The generation changes every time the
+ * block is freed, so keys kept after OSMemoryFreeBlock are rejected instead of aliasing
+ * the next allocation. The generation is 8 bits, after 255 frees of a block an old key of it
+ * is valid again.
  *
  * @param key used to access the memory block useing OSMemoryBlockGet
- * @param size number of bytes to get (see BlockSize_t)
- * @param status OS_MEMORY_SUCCESS if able to find a free block, OS_MEMORY_BLOCK_FULL otherwise
+ * @param size number of bytes to get, one of MEMORY_BLOCK_*
+ * @param status OS_SUCCESS if able to find a free block, OS_MEMORY_BLOCK_FULL otherwise,
+ *        OS_INVALID_ARGUMENT if size isn't a MEMORY_BLOCK_* size
  * @return uint8_t* pointer to block of memory
  */
 extern uint8_t* OSMemoryBlockNew(uint16_t* key, BlockSize_t size, OSStatus_t* status);
@@ -26,15 +35,18 @@ extern uint8_t* OSMemoryBlockNew(uint16_t* key, BlockSize_t size, OSStatus_t* st
 /**
  * @brief Gets a pointer to the block of memory encoded in the key
  *
+ * Stale keys are only caught until the block has been freed 255 more times, then the 8-bit
+ * generation wraps and the key matches again. Don't keep keys around that long.
+ *
  * @param key
- * @return uint8_t* pointer to the block of memory
+ * @return uint8_t* pointer to the block of memory, NULL if the key is stale or invalid
  */
 extern uint8_t* OSMemoryBlockGet(uint16_t key);
 
 /**
- * @brief Frees a block of memory so that it can be used again.
+ * @brief Frees a block of memory so that it can be used again, lock-free and ISR safe
  *
  * @param key
- * @return OSStatus_t OS_SUCCESS
+ * @return OSStatus_t OS_SUCCESS, OS_INVALID_ARGUMENT if the key is stale (double free) or invalid
  */
 extern OSStatus_t OSMemoryFreeBlock(uint16_t key);
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "os_defs.h"
+#include "os_util.h"
 
 /**
  * @brief Queue status
@@ -17,9 +18,28 @@ typedef enum MessageQueueStatus_e
     MSG_Q_FULL //!< no space left
 } MessageQueueStatus_t;
 
+/**
+ * @brief What a queue does with a message it can't simply append
+ *
+ */
+typedef enum MessageQueuePolicy_e
+{
+    MSG_Q_POLICY_REJECT = 0, //!< full queue rejects the new message, MSG_Q_FULL
+    MSG_Q_POLICY_COALESCE, //!< queued message with the same id is replaced in place, latest value
+    MSG_Q_POLICY_DROP_OLDEST, //!< full queue drops its oldest message
+} MessageQueuePolicy_t;
+
+/**
+ * @brief Called when a queue fills up to its high watermark, runs in the producer's context
+ *
+ * @param ao AO owning the queue
+ * @param count messages in the queue
+ */
+typedef void (*MessageQueueWatermark_f)(ActiveObject_t* ao, uint16_t count);
+
 struct MessageGeneric_s
 {
-    uint8_t placeholder[OS_MESSAGE_MAX_SIZE];
+    uint8_t placeholder[OS_MESSAGE_MAX_SIZE] __attribute__((aligned(4))); //!< word-wide copies
 };
 
 /**
@@ -46,17 +66,103 @@ struct MemoryBlockMessage_s
     uint8_t   size;
 };
 
+/**
+ * @brief Copies a message into a queue slot, fixed-size copies for the kernel's message types
+ *
+ * Messages start with Message_t, so both the message and the slot are word aligned.
+ *
+ * @param dest
+ * @param msg
+ */
+static inline void MsgCopy(void* dest, const Message_t* msg)
+{
+    switch (msg->msg_size)
+    {
+        case sizeof(Message_t):
+            os_memcpy_words(dest, msg, sizeof(Message_t) / 4);
+            break;
+
+        case sizeof(MemoryBlockMessage_t):
+            os_memcpy_words(dest, msg, sizeof(MemoryBlockMessage_t) / 4);
+            break;
+
+        case sizeof(DataMessage_t):
+            os_memcpy_words(dest, msg, sizeof(DataMessage_t) / 4);
+            break;
+
+        default:
+            os_memcpy(dest, msg, msg->msg_size);
+            break;
+    }
+}
+
+/**
+ * @brief Delivered to an AO when event flags have been set, see ActiveObjectSetFlags
+ */
+struct EventFlagsMessage_s
+{
+    Message_t base;
+    uint32_t  flags; //!< flags set since the last notification
+};
+
+//! end of an overflow slot list
+#define MSG_OVERFLOW_NONE 0xFFFF
+
+/**
+ * @brief Macro to declare the slots of the shared overflow pool
+ *
+ */
+#define MSG_OVERFLOW_POOL_DECL(name, size) MessageOverflowSlot_t name[size];
+
+/**
+ * @brief Slot of the shared overflow pool
+ */
+typedef struct MessageOverflowSlot_s
+{
+    MessageGeneric_t msg;
+    uint16_t         next; //!< next slot in a queue's overflow list or in the free list
+} MessageOverflowSlot_t;
+
+/**
+ * @brief Kernel-wide pool of message slots queues borrow from when their own buffer is full
+ */
+typedef struct MessageOverflowPool_s
+{
+    MessageOverflowSlot_t* slots;
+    uint16_t               size; //!< number of slots
+    uint16_t               free_head; //!< first free slot
+    uint16_t               in_use; //!< slots lent to queues
+    uint16_t               peak_in_use; //!< highest in_use since init, to size the pool and queues
+    uint32_t               exhausted; //!< borrows refused because no slot was free
+} MessageOverflowPool_t;
+
 /**
  * @brief Queue for messages, each AO should have one
  *
  */
 struct MessageQueue_s
 {
-    MessageGeneric_t* queue; //!< buffer
-    volatile uint16_t head; //!< index
-    volatile uint16_t tail; //!< index
-    uint16_t          size; //!< buffer size
-    bool              is_full;
+    MessageGeneric_t*       queue; //!< buffer
+    volatile uint16_t       head; //!< index, byte offset in packed mode
+    volatile uint16_t       tail; //!< index, byte offset in packed mode
+    uint16_t                size; //!< buffer size, bytes in packed mode
+    bool                    is_full;
+    bool                    is_packed; //!< messages stored back to back by msg_size
+    uint16_t                used; //!< packed mode: bytes not free, including held
+    uint16_t                held; //!< packed mode: bytes of the message being handled
+    uint16_t                count; //!< packed mode: messages not read yet
+    uint16_t                borrow_cap; //!< overflow slots this queue may borrow, 0 disables
+    uint16_t                borrowed; //!< overflow slots held, including the one being handled
+    uint16_t                peak_borrowed; //!< highest borrowed since creation
+    uint16_t                overflow_count; //!< messages waiting in overflow slots
+    uint16_t                overflow_head; //!< oldest message in overflow slots
+    uint16_t                overflow_tail; //!< newest message in overflow slots
+    uint16_t                overflow_held; //!< overflow slot being handled
+    MessageQueuePolicy_t    policy; //!< overflow policy, MSG_Q_POLICY_REJECT by default
+    uint16_t                high_watermark; //!< count calling on_HighWatermark, 0 disables
+    MessageQueueWatermark_f on_HighWatermark;
+    uint16_t                dropped; //!< messages rejected or dropped as oldest
+    uint16_t                coalesced; //!< messages replaced in place
 };
 
 /**
@@ -77,15 +183,110 @@ extern bool MsgQueueIsEmpty(MessageQueue_t* q);
  */
 extern void MsgQueueCreate(MessageQueue_t* q, const uint16_t size, MessageGeneric_t* queue);
 
+/**
+ * @brief Creates a packed message queue
+ *
+ * Messages take their msg_size rounded up to 4 bytes instead of a whole MessageGeneric_t,
+ * and can be up to 255 bytes. DROP_OLDEST can only make room while the AO isn't handling
+ * a message from this queue.
+ *
+ * @param q
+ * @param size_bytes buffer size in bytes, multiple of 4
+ * @param buffer 4 byte aligned buffer
+ */
+extern void MsgQueueCreatePacked(MessageQueue_t* q, const uint16_t size_bytes, void* buffer);
+
+/**
+ * @brief Sets up the kernel-wide overflow pool, see MsgQueueSetOverflow
+ *
+ * @param slots buffer declared with MSG_OVERFLOW_POOL_DECL
+ * @param size number of slots
+ */
+extern void MsgOverflowPoolInit(MessageOverflowSlot_t* slots, uint16_t size);
+
+/**
+ * @brief Overflow pool usage statistics
+ *
+ * @return const MessageOverflowPool_t*
+ */
+extern const MessageOverflowPool_t* MsgOverflowPoolGet();
+
+/**
+ * @brief Lets a queue borrow slots from the overflow pool once its own buffer is full
+ *
+ * Borrowed slots go back to the pool as soon as their message has been handled.
+ * Only for queues created with MsgQueueCreate.
+ *
+ * Once a message is in a borrowed slot, the next ones are borrowed as well until those are
+ * handled, so messages stay in order. While the queue holds borrowed messages,
+ * MSG_Q_POLICY_DROP_OLDEST acts as MSG_Q_POLICY_REJECT: a put that can't borrow is refused,
+ * since dropping the oldest message from the own buffer would reorder them. The oldest message
+ * is only dropped when the own buffer is full, nothing is borrowed, and borrowing fails.
+ *
+ * @param q
+ * @param borrow_cap most slots the queue may hold at once, so one AO can't starve the others
+ */
+extern void MsgQueueSetOverflow(MessageQueue_t* q, uint16_t borrow_cap);
+
+/**
+ * @brief Frees the message returned by the last MsgQueueGet, called once it has been handled
+ *
+ * @param q
+ */
+extern void MsgQueueRelease(MessageQueue_t* q);
+
+/**
+ * @brief Number of messages in the queue
+ *
+ * @param q
+ * @return uint16_t
+ */
+extern uint16_t MsgQueueCount(MessageQueue_t* q);
+
+/**
+ * @brief Sets what happens to messages that can't simply be appended
+ *
+ * @param q
+ * @param policy
+ */
+extern void MsgQueueSetPolicy(MessageQueue_t* q, MessageQueuePolicy_t policy);
+
+/**
+ * @brief Sets a callback for when the queue fills up to a level, so producers can throttle
+ *
+ * Called once each time the count rises to level, with interrupts enabled
+ * but still in the producer's (possibly ISR) context. A put that leaves the count
+ * at level, like drop-oldest on a full queue, doesn't call it again.
+ *
+ * @param q
+ * @param level count to call at, 0 disables
+ * @param callback
+ */
+extern void MsgQueueSetHighWatermark(MessageQueue_t* q, uint16_t level,
+                                     MessageQueueWatermark_f callback);
+
 /**
  * @brief Adds message to queue
  *
+ * What happens when the message can't simply be appended depends on the queue policy,
+ * see MessageQueuePolicy_t.
+ *
  * @param dest
  * @param msg
- * @return MessageQueueStatus_t
+ * @return MessageQueueStatus_t MSG_Q_FULL if rejected, MSG_Q_ERROR if a packed queue can never
+ *         hold msg (msg_size below sizeof(Message_t) or larger than the buffer)
  */
 extern MessageQueueStatus_t MsgQueuePut(ActiveObject_t* dest, void* msg);
 
+/**
+ * @brief Used by the kernel to dispatch timed events, MsgQueuePut recorded as a timed event
+ *
+ * @param dest
+ * @param msg
+ * @return MessageQueueStatus_t see MsgQueuePut
+ */
+extern MessageQueueStatus_t MsgQueuePutTimed(ActiveObject_t* dest, void* msg);
+
 /**
  * @brief Gets the next message from the queue, ONLY BLOCKING FUNCTION IN OS
  *
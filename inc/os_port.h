@@ -0,0 +1,42 @@
+/**
+ * @file os_port.h
+ */
+
+#pragma once
+
+#include "os_defs.h"
+
+/**
+ * @brief Starts the free-running cycle counter backing the 64-bit timebase
+ *
+ */
+extern void OSPortCycleCounterInit();
+
+/**
+ * @brief Reads the free-running 32-bit cycle counter
+ *
+ * @return uint32_t
+ */
+extern uint32_t OSPortCycleCounterRead();
+
+/**
+ * @brief Arms the one-shot high resolution timer, implemented by the board support
+ *        on a spare hardware timer. Its ISR must call HrTimerProcess. Only used with
+ *        OS_CFG_HRTIMER, of the ports only the host port provides it.
+ *
+ * @param cycles delay from now in cycles
+ */
+extern void OSPortHrTimerSet(uint32_t cycles);
+
+/**
+ * @brief Disarms the high resolution timer, implemented by the board support
+ *
+ */
+extern void OSPortHrTimerCancel();
+
+/**
+ * @brief Checks if the caller runs in an exception handler
+ *
+ * @return true in handler mode
+ */
+extern bool OSPortInIsr();
@@ -0,0 +1,168 @@
+/**
+ * @file os_proxy.h
+ */
+
+#pragma once
+
+#include "os.h"
+
+//! first byte of a frame
+#define PROXY_FRAME_SYNC 0xA5
+
+//! sync, 16-bit payload length, payload, 16-bit CRC
+#define PROXY_FRAME_HEADER   3
+#define PROXY_FRAME_OVERHEAD 5
+
+typedef struct ProxyReceiver_s ProxyReceiver_t;
+
+//! what the transport did with a frame
+typedef enum ProxyTransportStatus_e
+{
+    PROXY_TRANSPORT_DONE = 0, //!< sent or copied, the frame buffer can be reused
+    PROXY_TRANSPORT_BUSY, //!< taken, the buffer is read until ProxyLinkSendComplete
+    PROXY_TRANSPORT_ERROR //!< not taken, the frame is dropped
+} ProxyTransportStatus_t;
+
+/**
+ * @brief Sends a whole frame to the peer node (UART, SPI, pipe, ...)
+ *
+ * Only called from the link's flush, one frame at a time. A synchronous transport returns
+ * PROXY_TRANSPORT_DONE. One that keeps reading the frame afterwards, e.g. DMA, returns
+ * PROXY_TRANSPORT_BUSY and calls ProxyLinkSendComplete when done, no frame is flushed before.
+ *
+ * @param context
+ * @param frame
+ * @param len
+ * @return ProxyTransportStatus_t
+ */
+typedef ProxyTransportStatus_t (*ProxyTransport_f)(void* context, const uint8_t* frame,
+                                                   uint16_t len);
+
+/**
+ * @brief Sending side of a link to a peer node
+ *
+ * Messages posted to proxies are appended to a frame in place: a byte with the remote AO id,
+ * then the message. All messages posted before the flush runs, at flush_priority through a
+ * deferred call, go out in one frame. Two frame buffers alternate, messages are appended to one
+ * while the transport has the other.
+ */
+struct ProxyLink_s
+{
+    ProxyTransport_f transport;
+    void*            context; //!< passed to transport
+    uint8_t*         buffers[2]; //!< frame buffers
+    uint16_t         size; //!< bytes per frame buffer
+    uint16_t         used; //!< bytes in the frame being filled, header included
+    uint8_t          active; //!< frame buffer being filled
+    uint8_t          flush_priority; //!< priority of the deferred flush
+    bool             flush_pending; //!< flush queued as a deferred call
+    bool             sending; //!< the transport has the other frame buffer
+    uint32_t         frames; //!< frames taken by the transport
+    uint32_t         messages; //!< messages sent
+    uint32_t         dropped; //!< messages that didn't fit, frames the transport didn't take
+    ProxyLink_t*     next; //!< links checked by ProxyRetryFlushes
+};
+
+/**
+ * @brief Receiving side of a link, re-injects messages into local AOs
+ *
+ */
+struct ProxyReceiver_s
+{
+    ActiveObject_t* const* aos; //!< local AOs indexed by id
+    uint16_t               ao_count;
+    uint8_t*               buffer; //!< payload of the frame being received
+    uint16_t               size;
+    uint8_t                state; //!< parser state
+    uint16_t               length; //!< payload length of the frame being received
+    uint16_t               received; //!< payload bytes received
+    uint16_t               crc; //!< received CRC
+    uint32_t               frames; //!< valid frames
+    uint32_t               crc_errors; //!< corrupt or oversized frames, records too short
+    uint32_t               dropped; //!< messages for unknown AOs, larger than a slot, full queues
+};
+
+/**
+ * @brief Initialize a link
+ *
+ * @param link
+ * @param transport
+ * @param context
+ * @param buffer 2 * size bytes
+ * @param size bytes per frame, at most 0xFFFF
+ * @param flush_priority AO priority the frame is sent at
+ */
+extern void ProxyLinkInit(ProxyLink_t* link, ProxyTransport_f transport, void* context,
+                          uint8_t* buffer, uint16_t size, uint8_t flush_priority);
+
+/**
+ * @brief Make an AO a proxy of a remote AO, messages posted to it are sent over the link
+ *
+ * Only MsgQueuePut is supported. A proxy has no queue, ActiveObjectSetFlags, SharedStateSubscribe
+ * and StreamSetConsumer reject it.
+ *
+ * @param proxy
+ * @param link
+ * @param remote_id id of the AO on the peer node
+ */
+extern void ProxyCreate(ActiveObject_t* proxy, ProxyLink_t* link, uint8_t remote_id);
+
+/**
+ * @brief Used by MsgQueuePut, appends a message to the link's next frame
+ *
+ * @param proxy
+ * @param msg
+ * @return MessageQueueStatus_t MSG_Q_FULL if the frame is full
+ */
+extern MessageQueueStatus_t ProxySend(ActiveObject_t* proxy, Message_t* msg);
+
+/**
+ * @brief Send the frame being filled, normally run as a deferred call
+ *
+ * Does nothing while the transport is busy with the previous frame.
+ *
+ * @param link ProxyLink_t*
+ */
+extern void ProxyFlush(void* link);
+
+/**
+ * @brief Called by a transport that returned PROXY_TRANSPORT_BUSY once it's done with the frame,
+ *        ISR safe. Schedules the flush of messages posted in the meantime.
+ *
+ * @param link
+ */
+extern void ProxyLinkSendComplete(ProxyLink_t* link);
+
+/**
+ * @brief Initialize the receiving side of a link
+ *
+ * @param rx
+ * @param aos local AOs indexed by id, NULL entries are skipped
+ * @param ao_count
+ * @param buffer payload buffer, as large as the peer's frame size
+ * @param size
+ */
+extern void ProxyReceiverInit(ProxyReceiver_t* rx, ActiveObject_t* const* aos, uint16_t ao_count,
+                              uint8_t* buffer, uint16_t size);
+
+/**
+ * @brief Feed bytes received from the peer, valid frames are posted to the local AOs
+ *
+ * @param rx
+ * @param data
+ * @param len
+ */
+extern void ProxyReceive(ProxyReceiver_t* rx, const uint8_t* data, uint32_t len);
+
+#if OS_CFG_PROXY
+/**
+ * @brief Schedules flushes the defer pool had no room for, called by the system tick
+ *
+ */
+extern void ProxyRetryFlushes();
+#else
+// left out, nothing to retry on the system tick
+static inline void ProxyRetryFlushes()
+{
+}
+#endif
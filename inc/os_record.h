@@ -0,0 +1,138 @@
+/**
+ * @file os_record.h
+ */
+
+#pragma once
+
+#include "os.h"
+#include "os_stream.h"
+
+//! record kinds
+#define OS_RECORD_PUT   0 //!< MsgQueuePut
+#define OS_RECORD_TIMED 1 //!< timed event dispatch
+
+//! record sources other than AO ids
+#define OS_RECORD_SOURCE_TIMER 0xFD //!< timed event
+#define OS_RECORD_SOURCE_ISR   0xFE //!< any interrupt handler
+#define OS_RECORD_SOURCE_IDLE  0xFF //!< outside AOs, e.g. main or the idle hook
+
+typedef struct OSRecordHeader_s OSRecordHeader_t;
+typedef struct OSReplay_s       OSReplay_t;
+
+/**
+ * @brief Record header, followed by size bytes of message. Target byte order.
+ *
+ */
+struct OSRecordHeader_s
+{
+    uint8_t  kind; //!< OS_RECORD_PUT or OS_RECORD_TIMED
+    uint8_t  source; //!< sender AO id or OS_RECORD_SOURCE_*
+    uint8_t  dest; //!< destination AO id
+    uint8_t  size; //!< message size
+    uint8_t  status; //!< MessageQueueStatus_t of the put
+    uint8_t  reserved[3]; //!< 0, no padding bytes of unknown value in the log
+    uint32_t delta_us; //!< time since the previous record
+};
+
+/**
+ * @brief Feeds a recorded log back into the kernel
+ *
+ */
+struct OSReplay_s
+{
+    const uint8_t*         log;
+    uint32_t               length; //!< bytes in log
+    uint32_t               offset; //!< next record
+    ActiveObject_t* const* aos; //!< AOs indexed by id
+    uint16_t               ao_count;
+    bool                   inject_timed; //!< false if the application runs its own timed events
+    uint64_t               time_us; //!< recorded time of the next record, from the first one
+    uint32_t               injected; //!< records posted again
+    uint32_t               skipped; //!< records sent by AOs, replayed by the AOs themselves
+    uint32_t               rejected; //!< records of puts that failed, not posted
+};
+
+/**
+ * @brief Start recording message traffic into a stream
+ *
+ * Needs OS_RECORD_ENABLED. Every MsgQueuePut and timed event dispatch is written as a
+ * OSRecordHeader_t and the message once the put returned, with its status. Records that don't
+ * fit are dropped whole. The stream consumer (e.g. a logger AO writing to flash or UART) is
+ * notified as for any producer.
+ *
+ * @param stream
+ */
+extern void OSRecordStart(Stream_t* stream);
+
+/**
+ * @brief Stop recording
+ *
+ */
+extern void OSRecordStop();
+
+/**
+ * @brief Records dropped because the stream was full
+ *
+ * @return uint32_t
+ */
+extern uint32_t OSRecordDropped();
+
+/**
+ * @brief Used by the kernel after a put, appends a record
+ *
+ * @param kind
+ * @param dest
+ * @param msg
+ * @param status what the put returned
+ */
+extern void OSRecordMessage(uint8_t kind, ActiveObject_t* dest, Message_t* msg,
+                            MessageQueueStatus_t status);
+
+/**
+ * @brief Initialize a replay of a recorded log
+ *
+ * Records sent by ISRs, timed events and outside AOs are posted again through MsgQueuePut,
+ * records sent by AOs are skipped since replaying their inputs makes them send them again.
+ * Puts that failed (e.g. a full queue) were never delivered and aren't posted either.
+ *
+ * @param replay
+ * @param log
+ * @param length
+ * @param aos AOs indexed by id, NULL entries are skipped
+ * @param ao_count
+ * @param inject_timed true to post recorded timed events again
+ */
+extern void OSReplayInit(OSReplay_t* replay, const uint8_t* log, uint32_t length,
+                         ActiveObject_t* const* aos, uint16_t ao_count, bool inject_timed);
+
+/**
+ * @brief Post the next record, as fast as possible replay
+ *
+ * @code
+ * while (OSReplayNext(&replay))
+ * {
+ *     SchedulerActivateAO();
+ * }
+ * @endcode
+ *
+ * @param replay
+ * @return false at the end of the log
+ */
+extern bool OSReplayNext(OSReplay_t* replay);
+
+/**
+ * @brief Post every record due by now, recorded speed replay
+ *
+ * @param replay
+ * @param now_us time since the replay started
+ * @return uint32_t records posted
+ */
+extern uint32_t OSReplayUntil(OSReplay_t* replay, uint64_t now_us);
+
+/**
+ * @brief Check if the whole log has been replayed
+ *
+ * @param replay
+ * @return true if done
+ */
+extern bool OSReplayDone(OSReplay_t* replay);
@@ -0,0 +1,83 @@
+/**
+ * @file os_shared.h
+ */
+
+#pragma once
+
+#include "os.h"
+
+typedef struct SharedState_s SharedState_t;
+
+/**
+ * @brief Macro to declare a shared state holding a value of type
+ *
+ */
+#define SHARED_STATE_DECL(name, type)                                                              \
+    static type   name##_value;                                                                    \
+    SharedState_t name = {0, &name##_value, sizeof(type), {NULL}, {0}, 0};
+
+/**
+ * @brief Latest-value data from one writer to any number of AO readers, guarded by a seqlock
+ *
+ * The writer never waits and never disables interrupts. Readers copy the value and retry if a
+ * publish ran meanwhile. The writer is a single ISR or AO, readers are AOs only, since a reader
+ * preempting the writer mid publish would spin forever.
+ */
+struct SharedState_s
+{
+    volatile uint32_t sequence; //!< odd while a publish is in progress
+    void*             value; //!< storage, size bytes
+    uint16_t          size;
+    ActiveObject_t*   subscribers[SHARED_STATE_MAX_SUBSCRIBERS]; //!< notified on publish
+    uint32_t          flags[SHARED_STATE_MAX_SUBSCRIBERS]; //!< event flags set on each subscriber
+    uint8_t           subscriber_count;
+};
+
+/**
+ * @brief Initialize a shared state on caller provided storage
+ *
+ * @param state
+ * @param value storage for the value, size bytes
+ * @param size
+ */
+extern void SharedStateInit(SharedState_t* state, void* value, uint16_t size);
+
+/**
+ * @brief Set event flags on an AO every time a value is published
+ *
+ * Flags coalesce, so a subscriber is readied at most once however many values are published
+ * before it runs. It gets them in an EventFlagsMessage_t, see ActiveObjectSetFlags.
+ *
+ * @param state
+ * @param ao
+ * @param flags
+ * @return OSStatus_t OS_INVALID_ARGUMENT if there are SHARED_STATE_MAX_SUBSCRIBERS already or
+ *         ao is a proxy
+ */
+extern OSStatus_t SharedStateSubscribe(SharedState_t* state, ActiveObject_t* ao, uint32_t flags);
+
+/**
+ * @brief Publish a new value, single writer only. ISR safe, doesn't disable interrupts.
+ *
+ * @param state
+ * @param value size bytes
+ */
+extern void SharedStatePublish(SharedState_t* state, const void* value);
+
+/**
+ * @brief Copy a consistent snapshot of the latest value, retrying while publishes interfere.
+ *        AOs only.
+ *
+ * @param state
+ * @param value receives size bytes
+ * @return uint32_t number of values published so far, to tell if the value has changed
+ */
+extern uint32_t SharedStateRead(SharedState_t* state, void* value);
+
+/**
+ * @brief Number of values published so far, without reading the value
+ *
+ * @param state
+ * @return uint32_t
+ */
+extern uint32_t SharedStateVersion(SharedState_t* state);
@@ -0,0 +1,160 @@
+/**
+ * @file os_stream.h
+ */
+
+#pragma once
+
+#include "os.h"
+
+typedef struct Stream_s Stream_t;
+
+//! STREAM_DECL checks its size at compile time, in C and C++
+#ifdef __cplusplus
+    #define STREAM_STATIC_ASSERT static_assert
+#else
+    #define STREAM_STATIC_ASSERT _Static_assert
+#endif
+
+/**
+ * @brief Macro to declare a stream with its buffer, size must be a power of 2
+ *
+ */
+#define STREAM_DECL(name, size)                                                                    \
+    STREAM_STATIC_ASSERT((size) > 0 && 0 == ((size) & ((size) - 1)),                               \
+                         "stream " #name ": size must be a power of 2");                           \
+    static uint8_t name##_buffer[(size)];                                                          \
+    Stream_t       name = {name##_buffer, (size), 0, 0, NULL, 0, 1, 0};
+
+/**
+ * @brief Single producer, single consumer byte stream, lock-free
+ *
+ * The producer (ISR, DMA or AO) and the consumer (AO) each own one index, head and tail
+ * count bytes since init and only their difference matters. Both sides can work on the
+ * buffer in place through linear windows, see StreamWriteAcquire and StreamReadAcquire.
+ */
+struct Stream_s
+{
+    uint8_t*          buffer;
+    uint32_t          size; //!< power of 2
+    volatile uint32_t head; //!< bytes written, producer only
+    volatile uint32_t tail; //!< bytes read, consumer only
+    ActiveObject_t*   consumer; //!< notified through event flags, may be NULL
+    uint32_t          flags; //!< event flags set on the consumer
+    uint32_t          threshold; //!< bytes available that notify the consumer
+    uint32_t          overruns; //!< writes that didn't fit, or data overwritten by DMA
+};
+
+/**
+ * @brief Initialize a stream on caller provided storage
+ *
+ * @param stream
+ * @param buffer
+ * @param size power of 2
+ * @return OSStatus_t OS_INVALID_ARGUMENT if size isn't a power of 2
+ */
+extern OSStatus_t StreamInit(Stream_t* stream, uint8_t* buffer, uint32_t size);
+
+/**
+ * @brief Set the AO consuming the stream
+ *
+ * The consumer gets its flags (see ActiveObjectSetFlags) when a commit leaves at least threshold
+ * bytes in the stream, and on StreamIdle. It is readied once however many commits happen
+ * before it runs.
+ *
+ * @param stream
+ * @param consumer
+ * @param flags
+ * @param threshold 1 to be notified on every commit
+ * @return OSStatus_t OS_INVALID_ARGUMENT if consumer is a proxy
+ */
+extern OSStatus_t StreamSetConsumer(Stream_t* stream, ActiveObject_t* consumer, uint32_t flags,
+                                    uint32_t threshold);
+
+/**
+ * @brief Bytes ready to be read
+ *
+ * @param stream
+ * @return uint32_t
+ */
+extern uint32_t StreamAvailable(Stream_t* stream);
+
+/**
+ * @brief Bytes that can be written
+ *
+ * @param stream
+ * @return uint32_t
+ */
+extern uint32_t StreamFree(Stream_t* stream);
+
+/**
+ * @brief Producer: get the largest linear free window, to fill in place (e.g. by DMA)
+ *
+ * @param stream
+ * @param window set to the start of the window
+ * @return uint32_t window length, may be less than StreamFree at the end of the buffer
+ */
+extern uint32_t StreamWriteAcquire(Stream_t* stream, uint8_t** window);
+
+/**
+ * @brief Producer: make count bytes of the acquired window readable
+ *
+ * @param stream
+ * @param count
+ */
+extern void StreamWriteCommit(Stream_t* stream, uint32_t count);
+
+/**
+ * @brief Producer: copy data into the stream
+ *
+ * @param stream
+ * @param data
+ * @param len
+ * @return uint32_t bytes written, a short write counts as an overrun
+ */
+extern uint32_t StreamWrite(Stream_t* stream, const void* data, uint32_t len);
+
+/**
+ * @brief Producer: commit what a circular DMA transfer into the whole buffer wrote so far
+ *
+ * Call from the DMA half and full transfer interrupts (double buffering) and from the UART
+ * idle interrupt. DMA doesn't wait for the consumer, data it overwrites is counted as an
+ * overrun.
+ *
+ * @param stream
+ * @param position offset in the buffer DMA writes next
+ */
+extern void StreamDmaCommit(Stream_t* stream, uint32_t position);
+
+/**
+ * @brief Producer: notify the consumer of data below the threshold, e.g. on line idle
+ *
+ * @param stream
+ */
+extern void StreamIdle(Stream_t* stream);
+
+/**
+ * @brief Consumer: get the largest linear readable window, to process in place
+ *
+ * @param stream
+ * @param window set to the start of the window
+ * @return uint32_t window length, may be less than StreamAvailable at the end of the buffer
+ */
+extern uint32_t StreamReadAcquire(Stream_t* stream, const uint8_t** window);
+
+/**
+ * @brief Consumer: free count bytes of the acquired window
+ *
+ * @param stream
+ * @param count
+ */
+extern void StreamReadRelease(Stream_t* stream, uint32_t count);
+
+/**
+ * @brief Consumer: copy data out of the stream
+ *
+ * @param stream
+ * @param data
+ * @param len
+ * @return uint32_t bytes read
+ */
+extern uint32_t StreamRead(Stream_t* stream, void* data, uint32_t len);
@@ -0,0 +1,81 @@
+/**
+ * @file os_time.h
+ */
+
+#pragma once
+
+#include "os_defs.h"
+
+/**
+ * @brief High resolution one-shot timer, dispatches a message to an AO
+ *        from the board's hardware timer ISR
+ *
+ */
+typedef struct HrTimer_s HrTimer_t;
+
+struct HrTimer_s
+{
+    ActiveObject_t* dest; //!< active object receiving dispatched message
+    void*           message; //!< message to dispatch
+    uint64_t        deadline; //!< OSGetCycles value to dispatch at
+    bool            active;
+    uint16_t        dropped; //!< dispatches lost to a full queue
+    HrTimer_t*      next; //!< next timer by deadline
+};
+
+/**
+ * @brief Starts the cycle counter for the 64-bit timebase
+ *
+ * @param cpu_hz cycle counter frequency, multiple of 1 MHz
+ */
+extern void OSTimebaseInit(uint32_t cpu_hz);
+
+/**
+ * @brief Monotonic 64-bit cycle count
+ *
+ * Extends the port's 32-bit counter, SysTick_Handler reads it often enough to catch every wrap
+ *
+ * @return uint64_t
+ */
+extern uint64_t OSGetCycles();
+
+/**
+ * @brief Monotonic 64-bit time since OSTimebaseInit (us)
+ *
+ * @return uint64_t
+ */
+extern uint64_t OSGetTimeUs();
+
+/**
+ * @brief Converts microseconds to cycles of the timebase
+ *
+ * @param us
+ * @return uint64_t
+ */
+extern uint64_t OSTimeUsToCycles(uint32_t us);
+
+/**
+ * @brief Starts (or restarts) a one-shot high resolution timer
+ *
+ * Needs OS_CFG_HRTIMER and OSPortHrTimerSet/OSPortHrTimerCancel from the board support
+ *
+ * @param timer
+ * @param dest
+ * @param msg message to dispatch, must stay valid until then
+ * @param delay_us
+ */
+extern void HrTimerStart(HrTimer_t* timer, ActiveObject_t* dest, void* msg, uint32_t delay_us);
+
+/**
+ * @brief Stops a high resolution timer
+ *
+ * @param timer
+ */
+extern void HrTimerStop(HrTimer_t* timer);
+
+/**
+ * @brief Dispatches expired high resolution timers and re-arms the hardware timer.
+ *        Called from the board's timer ISR, between OS_ISR_ENTER and OS_ISR_EXIT.
+ *
+ */
+extern void HrTimerProcess();
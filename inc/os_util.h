@@ -6,12 +6,38 @@
 
 #include <stdint.h>
 
+//! word that may alias any type, for word-wide copies of structs
+typedef uint32_t __attribute__((may_alias)) os_word_t;
+
+//! word at any address, single LDR on Cortex-M4 (unaligned access is not trapped by default)
+typedef uint32_t __attribute__((may_alias, aligned(1))) os_unaligned_word_t;
+
 /**
  * @brief Copies memory from source to destination
  *
+ * Word-wide once the destination is aligned, byte-wise for short copies and the head and tail.
+ *
  * @param dest
  * @param src
  * @param len
  * @return void*
  */
 extern void* os_memcpy(void* dest, const void* src, uint32_t len);
+
+/**
+ * @brief Copies whole words, both pointers word aligned. Unrolled when words is a constant.
+ *
+ * @param dest
+ * @param src
+ * @param words
+ */
+static inline void os_memcpy_words(void* dest, const void* src, uint32_t words)
+{
+    os_word_t*       d = (os_word_t*)dest;
+    const os_word_t* s = (const os_word_t*)src;
+
+    for (uint32_t i = 0; i < words; i++)
+    {
+        d[i] = s[i];
+    }
+}
@@ -0,0 +1,199 @@
+/**
+ * @file rmk.hpp
+ *
+ * Header-only C++17 layer over the C API. Everything resolves at compile time, the
+ * generated code is the same as a C handler switching on msg->id.
+ */
+
+#pragma once
+
+extern "C" {
+#include "os.h"
+#include "os_msg.h"
+}
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace rmk
+{
+
+/**
+ * @brief Base of typed messages, sets id and size on construction
+ *
+ * @code
+ * struct Speed : rmk::Message<Speed, SPEED_MSG_ID>
+ * {
+ *     int16_t rpm;
+ * };
+ * @endcode
+ */
+template <typename Derived, uint32_t Id>
+struct Message : Message_t
+{
+    static constexpr uint32_t id_value = Id;
+
+    Message() : Message_t{Id, static_cast<uint8_t>(sizeof(Derived))}
+    {
+        static_assert(sizeof(Derived) <= OS_MESSAGE_MAX_SIZE, "message exceeds max size");
+        static_assert(std::is_trivially_copyable_v<Derived>, "messages are copied bytewise");
+    }
+};
+
+/**
+ * @brief List of the messages a handler accepts
+ *
+ */
+template <typename... Msgs>
+struct Messages
+{
+};
+
+namespace detail
+{
+
+template <typename Handler, typename = void>
+struct HasUnhandled : std::false_type
+{
+};
+
+template <typename Handler>
+struct HasUnhandled<Handler,
+                    std::void_t<decltype(Handler::on_Unhandled(std::declval<Message_t*>()))>>
+    : std::true_type
+{
+};
+
+template <uint32_t... Ids>
+constexpr bool UniqueIds()
+{
+    if constexpr (sizeof...(Ids) > 1)
+    {
+        constexpr uint32_t ids[] = {Ids...};
+
+        for (std::size_t i = 0; i < sizeof...(Ids); i++)
+        {
+            for (std::size_t j = i + 1; j < sizeof...(Ids); j++)
+            {
+                if (ids[i] == ids[j])
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename Handler, typename List>
+struct Dispatcher;
+
+template <typename Handler, typename... Msgs>
+struct Dispatcher<Handler, Messages<Msgs...>>
+{
+    static_assert(UniqueIds<Msgs::id_value...>(), "message ids of a handler must be unique");
+    static_assert(((sizeof(Msgs) <= OS_MESSAGE_MAX_SIZE) && ...),
+                  "message exceeds OS_MESSAGE_MAX_SIZE");
+
+    template <typename Msg>
+    static constexpr bool accepts = (std::is_same_v<Msg, Msgs> || ...);
+
+    /**
+     * @brief EventHandler_f of the AO, compare chain on the ids, compiled like a switch
+     *
+     * @param msg
+     */
+    static void Dispatch(Message_t* msg)
+    {
+        bool handled = ((msg->id == Msgs::id_value &&
+                         (Handler::on_Message(*static_cast<const Msgs*>(msg)), true)) ||
+                        ...);
+
+        if constexpr (HasUnhandled<Handler>::value)
+        {
+            if (!handled)
+            {
+                Handler::on_Unhandled(msg);
+            }
+        }
+        else
+        {
+            (void)handled;
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Active object with its queue, replaces ACTIVE_OBJECT_DECL and AO_INIT
+ *
+ * Handler lists the messages it accepts and has a static on_Message overload for each,
+ * plus an optional static on_Unhandled(Message_t*) for anything else (timeouts, flags, ...).
+ *
+ * @code
+ * struct Controller
+ * {
+ *     using Messages = rmk::Messages<Start, Speed>;
+ *
+ *     static void on_Message(const Start& msg);
+ *     static void on_Message(const Speed& msg);
+ * };
+ *
+ * rmk::ActiveObject<Controller, 8> controller{CONTROLLER_PRIORITY, CONTROLLER_ID};
+ *
+ * Speed speed;
+ * speed.rpm = 1200;
+ * controller.post(speed);
+ * @endcode
+ */
+template <typename Handler, uint16_t QueueDepth>
+class ActiveObject
+{
+    using Dispatcher = detail::Dispatcher<Handler, typename Handler::Messages>;
+
+    static_assert(QueueDepth > 0, "queue needs at least one slot");
+
+  public:
+    ActiveObject(uint8_t priority, uint8_t id)
+    {
+        MsgQueueCreate(&queue, QueueDepth, buffer);
+        ActiveObjectCreate(&ao, priority, &queue, &Dispatcher::Dispatch, id);
+    }
+
+    ActiveObject(const ActiveObject&) = delete;
+    ActiveObject& operator=(const ActiveObject&) = delete;
+
+    /**
+     * @brief Post a message, only messages the handler accepts compile
+     *
+     * @param msg copied into the queue
+     * @return MessageQueueStatus_t see MsgQueuePut
+     */
+    template <typename Msg>
+    MessageQueueStatus_t post(const Msg& msg)
+    {
+        static_assert(Dispatcher::template accepts<Msg>, "message not accepted by this handler");
+
+        return MsgQueuePut(&ao, const_cast<Msg*>(&msg));
+    }
+
+    /**
+     * @brief Underlying AO, for the C API (timed events, flags, ...)
+     *
+     * @return ActiveObject_t*
+     */
+    ActiveObject_t* get()
+    {
+        return &ao;
+    }
+
+  private:
+    ActiveObject_t   ao;
+    MessageQueue_t   queue;
+    MessageGeneric_t buffer[QueueDepth];
+};
+
+} // namespace rmk
@@ -23,6 +23,71 @@ struct Command_s
     Command_t* next;
 };
 
+/**
+ * @brief Join condition of a command group
+ */
+typedef enum CommandJoin_e
+{
+    COMMAND_JOIN_ALL = 0, //!< group done when every child is done
+    COMMAND_JOIN_ANY, //!< group done when the first child is done
+    COMMAND_JOIN_MASK, //!< group done when every child in join_mask is done
+} CommandJoin_t;
+
+//! children per group, one bit each in the completion masks
+#define COMMAND_GROUP_MAX_CHILDREN 32
+
+/**
+ * @brief Runs several commands in parallel as a single command
+ *
+ * All children start with the group, each message is delivered to every child still running.
+ * Children done before the join condition holds get on_End right away, children still
+ * running when it holds get on_End with the group. Children's next pointers are not used.
+ *
+ * The group owns base.end_behavior: every start sets it to COMMAND_ON_END_WAIT_FOR_END, or to
+ * COMMAND_ON_END_INSTANT if the join condition already holds once the children have started.
+ */
+typedef struct CommandGroup_s
+{
+    Command_t     base;
+    Command_t**   children;
+    uint8_t       count; //!< number of children, up to COMMAND_GROUP_MAX_CHILDREN
+    CommandJoin_t join;
+    uint32_t      join_mask; //!< children required by COMMAND_JOIN_MASK, bit n is children[n]
+    uint32_t      active_mask; //!< children started and not done
+    uint32_t      done_mask; //!< children done
+} CommandGroup_t;
+
+/**
+ * @brief Command message handler, returns true when the command is done
+ */
+typedef bool (*CommandMessageHandler_f)(Command_t* cmd, Message_t* msg, void* instance_data);
+
+/**
+ * @brief Dense message id -> command handler table, see MessageDispatchTable_t
+ */
+typedef struct CommandDispatchTable_s
+{
+    const CommandMessageHandler_f* handlers; //!< indexed by (id - base_id)
+    uint32_t                       base_id; //!< lowest id in the table
+    uint32_t                       count; //!< number of entries in handlers
+    CommandMessageHandler_f        default_handler; //!< ids without entry, may be NULL
+} CommandDispatchTable_t;
+
+/**
+ * @brief Macro to declare a command dispatch table and an on_Message function using it
+ *
+ * Assign name##_OnMessage to Command_t::on_Message. Entries use MSG_DISPATCH_ENTRY.
+ * Ids without a handler leave the command running.
+ */
+#define CMD_DISPATCH_TABLE_DECL(name, base_id, count, default_handler, ...)                        \
+    static const CommandMessageHandler_f name##_handlers[(count)] = {__VA_ARGS__};                 \
+    static const CommandDispatchTable_t  name = {name##_handlers, (base_id), (count),              \
+                                                (default_handler)};                                \
+    static bool name##_OnMessage(Command_t* cmd, Message_t* msg, void* instance_data)              \
+    {                                                                                              \
+        return CommandDispatch(&name, cmd, msg, instance_data);                                    \
+    }
+
 /**
  * @brief State machine instance data
  */
@@ -58,3 +123,30 @@ extern void StateMachineStart(StateMachine_t* sm, void* instance_data);
  * @return true if command is finished
  */
 extern bool StateMachineStep(StateMachine_t* sm, Message_t* msg, void* instance_data);
+
+/**
+ * @brief Initialize a parallel command group
+ *
+ * @param group
+ * @param children Commands to run in parallel, array must outlive the group
+ * @param count Number of children
+ * @param join Join condition
+ * @param join_mask Children required by COMMAND_JOIN_MASK, ignored otherwise
+ * @param next Command following the group, NULL ends the sequence
+ * @return OSStatus_t OS_INVALID_ARGUMENT if count is above COMMAND_GROUP_MAX_CHILDREN or
+ *         join_mask has a bit at or above count
+ */
+extern OSStatus_t CommandGroupInit(CommandGroup_t* group, Command_t** children, uint8_t count,
+                                   CommandJoin_t join, uint32_t join_mask, Command_t* next);
+
+/**
+ * @brief Calls the command handler registered for the message id
+ *
+ * @param table
+ * @param cmd
+ * @param msg
+ * @param instance_data
+ * @return true if command is done, false if not done or no handler for the id
+ */
+extern bool CommandDispatch(const CommandDispatchTable_t* table, Command_t* cmd, Message_t* msg,
+                            void* instance_data);
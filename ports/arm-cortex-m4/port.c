@@ -1,4 +1,5 @@
 #include <inc/os.h>
+#include <inc/os_port.h>
 
 /**
  *  NOTE
@@ -83,3 +84,31 @@ __attribute__((naked, optimize("-fno-stack-protector"))) void NMI_Handler(void)
 }
 
 // clang-format on
+
+//! DWT cycle counter registers
+#define DEMCR      (*((volatile uint32_t*)0xE000EDFCU))
+#define DWT_CTRL   (*((volatile uint32_t*)0xE0001000U))
+#define DWT_CYCCNT (*((volatile uint32_t*)0xE0001004U))
+
+void OSPortCycleCounterInit()
+{
+    // enable trace, then the cycle counter
+    DEMCR |= (1U << 24U);
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1U;
+}
+
+uint32_t OSPortCycleCounterRead()
+{
+    return DWT_CYCCNT;
+}
+
+bool OSPortInIsr()
+{
+    uint32_t ipsr;
+
+    // active exception number, 0 in thread mode
+    __asm volatile("MRS %0, ipsr" : "=r"(ipsr));
+
+    return 0U != ipsr;
+}
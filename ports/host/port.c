@@ -0,0 +1,207 @@
+/**
+ * @file port.c
+ *
+ * Host port, see port_host.h
+ */
+
+#include <inc/os.h>
+#include <inc/os_port.h>
+#include <ports/host/port_host.h>
+
+#include <signal.h>
+#include <time.h>
+
+//! see os.c
+extern void SysTick_Handler();
+
+//! interrupt state of the modelled core, only changed by the kernel thread and its signal handlers
+static volatile sig_atomic_t interrupts_disabled = 0;
+static volatile sig_atomic_t isr_nesting = 0;
+static volatile sig_atomic_t isr_pending = 0;
+static volatile sig_atomic_t scheduler_pending = 0;
+
+//! ISRs raised while interrupts were disabled
+static OSPortHostIsr_f pending[OS_PORT_HOST_PENDING_MAX];
+
+static void RunPending();
+
+/**
+ * @brief Runs ISRs held while interrupts were disabled, then the scheduler if it was pended
+ *
+ */
+static void RunPending()
+{
+    if (isr_pending)
+    {
+        isr_pending = 0;
+
+        for (uint8_t i = 0; i < OS_PORT_HOST_PENDING_MAX; i++)
+        {
+            OSPortHostIsr_f isr = __atomic_exchange_n(&pending[i], NULL, __ATOMIC_ACQ_REL);
+
+            if (isr)
+            {
+                OSPortHostIsr(isr);
+            }
+        }
+    }
+
+    // like PendSV, only once no ISR is active
+    if (0 == isr_nesting && 0 == interrupts_disabled && scheduler_pending)
+    {
+        scheduler_pending = 0;
+        SchedulerActivateAO();
+    }
+}
+
+void OSPortHostInterruptsEnable()
+{
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    interrupts_disabled = 0;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+    RunPending();
+}
+
+void OSPortHostInterruptsDisable()
+{
+    interrupts_disabled = 1;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+uint32_t OSPortHostInterruptsSave()
+{
+    uint32_t state = (uint32_t)interrupts_disabled;
+
+    OSPortHostInterruptsDisable();
+
+    return state;
+}
+
+void OSPortHostInterruptsRestore(uint32_t state)
+{
+    if (0U == state)
+    {
+        OSPortHostInterruptsEnable();
+    }
+}
+
+void OSPortHostPendScheduler()
+{
+    scheduler_pending = 1;
+}
+
+void OSPortHostIsr(OSPortHostIsr_f isr)
+{
+    if (interrupts_disabled)
+    {
+        // held, a second raise before it ran is the same pending bit
+        for (uint8_t i = 0; i < OS_PORT_HOST_PENDING_MAX; i++)
+        {
+            OSPortHostIsr_f expected = NULL;
+
+            if (isr == pending[i] ||
+                __atomic_compare_exchange_n(&pending[i], &expected, isr, false, __ATOMIC_ACQ_REL,
+                                            __ATOMIC_ACQUIRE))
+            {
+                isr_pending = 1;
+                return;
+            }
+        }
+
+        return;
+    }
+
+    isr_nesting++;
+    isr();
+    isr_nesting--;
+
+    if (0 == isr_nesting)
+    {
+        RunPending();
+    }
+}
+
+void OSPortHostTick()
+{
+    OSPortHostIsr(SysTick_Handler);
+}
+
+void OSPortCycleCounterInit()
+{
+}
+
+uint32_t OSPortCycleCounterRead()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // wraps every 4.3 s, OSGetCycles on every tick catches that
+    return (uint32_t)((uint64_t)now.tv_sec * OS_PORT_HOST_HZ + (uint64_t)now.tv_nsec);
+}
+
+bool OSPortInIsr()
+{
+    return 0 != isr_nesting;
+}
+
+#if OS_CFG_HRTIMER
+//! one-shot POSIX timer raising OS_PORT_HOST_HRTIMER_SIGNAL, created on first use
+static timer_t hr_timer;
+static bool    hr_timer_created = false;
+
+/**
+ * @brief The high resolution timer's ISR
+ *
+ */
+static void HrTimerIsr()
+{
+    OS_ISR_ENTER(OSGetOS());
+    HrTimerProcess();
+    OS_ISR_EXIT(OSGetOS());
+}
+
+static void OnHrTimerSignal(int signal)
+{
+    UNUSED(signal);
+    OSPortHostIsr(HrTimerIsr);
+}
+
+void OSPortHrTimerSet(uint32_t cycles)
+{
+    if (!hr_timer_created)
+    {
+        struct sigaction action = {0};
+        struct sigevent  event = {0};
+
+        action.sa_handler = OnHrTimerSignal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(OS_PORT_HOST_HRTIMER_SIGNAL, &action, NULL);
+
+        event.sigev_notify = SIGEV_SIGNAL;
+        event.sigev_signo = OS_PORT_HOST_HRTIMER_SIGNAL;
+        hr_timer_created = (0 == timer_create(CLOCK_MONOTONIC, &event, &hr_timer));
+    }
+
+    // cycles are nanoseconds, a zero it_value would disarm it
+    struct itimerspec value = {{0, 0}, {0, 0}};
+
+    cycles = (0U == cycles) ? 1U : cycles;
+    value.it_value.tv_sec = (time_t)(cycles / OS_PORT_HOST_HZ);
+    value.it_value.tv_nsec = (long)(cycles % OS_PORT_HOST_HZ);
+
+    timer_settime(hr_timer, 0, &value, NULL);
+}
+
+void OSPortHrTimerCancel()
+{
+    struct itimerspec value = {{0, 0}, {0, 0}};
+
+    if (hr_timer_created)
+    {
+        timer_settime(hr_timer, 0, &value, NULL);
+    }
+}
+#endif // OS_CFG_HRTIMER
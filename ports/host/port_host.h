@@ -0,0 +1,44 @@
+/**
+ * @file port_host.h
+ *
+ * Host port, builds the kernel for the machine running the build for tests and benchmarks.
+ *
+ * It models a single core. The kernel and its AOs run on one thread, interrupts are functions run
+ * through OSPortHostIsr, e.g. from a signal handler. While interrupts are disabled ISRs are held
+ * pending and run as soon as they are enabled again, like the NVIC does. The scheduler pended by
+ * OS_ISR_EXIT runs once no ISR is active, in the interrupted context, like PendSV.
+ *
+ * The cycle counter counts nanoseconds of CLOCK_MONOTONIC, see OS_PORT_HOST_HZ. With
+ * OS_CFG_HRTIMER the high resolution timer is a POSIX timer on the same clock, its signal raises
+ * the ISR calling HrTimerProcess.
+ */
+
+#pragma once
+
+#include <inc/os_defs.h>
+
+//! cycle counter frequency, pass it to OSTimebaseInit
+#define OS_PORT_HOST_HZ 1000000000U
+
+//! signal of the high resolution timer, see OSPortHrTimerSet
+#define OS_PORT_HOST_HRTIMER_SIGNAL SIGRTMIN
+
+//! ISRs pending at once while interrupts are disabled
+#define OS_PORT_HOST_PENDING_MAX 8
+
+typedef void (*OSPortHostIsr_f)(void);
+
+/**
+ * @brief Raises an interrupt, runs the ISR now or once interrupts are enabled again
+ *
+ * Safe to call from signal handlers. An ISR raised again before it ran runs once.
+ *
+ * @param isr
+ */
+extern void OSPortHostIsr(OSPortHostIsr_f isr);
+
+/**
+ * @brief Raises the system tick, SysTick_Handler
+ *
+ */
+extern void OSPortHostTick();
@@ -0,0 +1,239 @@
+/**
+ * @file hsm.c
+ */
+
+#include "inc/hsm.h"
+
+#if OS_CFG_HSM
+
+static void Enter(Hsm_t* hsm, const HsmState_t* state, void* instance_data);
+static void Exit(Hsm_t* hsm, const HsmState_t* state, void* instance_data);
+static uint32_t HsmLeafDepth(const HsmState_t* state);
+
+static void Enter(Hsm_t* hsm, const HsmState_t* state, void* instance_data)
+{
+    if (state->on_Entry)
+    {
+        state->on_Entry(hsm, instance_data);
+    }
+}
+
+static void Exit(Hsm_t* hsm, const HsmState_t* state, void* instance_data)
+{
+    if (state->on_Exit)
+    {
+        state->on_Exit(hsm, instance_data);
+    }
+}
+
+/**
+ * @brief Nesting depth of the leaf reached from state through its initial substates,
+ *        stops counting past HSM_MAX_DEPTH so a cycle doesn't hang it
+ *
+ * @param state
+ * @return uint32_t 1 for a top level leaf
+ */
+static uint32_t HsmLeafDepth(const HsmState_t* state)
+{
+    uint32_t depth = 0;
+
+    for (const HsmState_t* s = state; s && depth <= HSM_MAX_DEPTH; s = s->parent)
+    {
+        depth++;
+    }
+
+    for (const HsmState_t* s = state->initial; s && depth <= HSM_MAX_DEPTH; s = s->initial)
+    {
+        depth++;
+    }
+
+    return depth;
+}
+
+extern OSStatus_t HsmTransitionInit(HsmTransition_t* transition, const HsmState_t* source,
+                                    const HsmState_t* target)
+{
+    const HsmState_t* target_chain[HSM_MAX_DEPTH];
+    uint8_t           target_depth = 0;
+    const HsmState_t* lca = NULL;
+    const HsmState_t* state;
+
+    if (!source || !target)
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    transition->source = source;
+    transition->target = target;
+    transition->exit_count = 0;
+    transition->entry_count = 0;
+
+    // the leaf the transition ends in has to fit as well
+    if (HSM_MAX_DEPTH < HsmLeafDepth(target))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    // target and its ancestors, bottom up
+    for (state = target; state; state = state->parent)
+    {
+        target_chain[target_depth++] = state;
+    }
+
+    // walk up from the source, exiting until reaching a strict ancestor of the target
+    for (state = source; state; state = state->parent)
+    {
+        for (uint8_t i = 1; i < target_depth; i++)
+        {
+            if (state != source && target_chain[i] == state)
+            {
+                lca = state;
+                break;
+            }
+        }
+
+        if (lca)
+        {
+            break;
+        }
+
+        if (HSM_MAX_DEPTH == transition->exit_count)
+        {
+            return OS_INVALID_ARGUMENT;
+        }
+
+        transition->exit_path[transition->exit_count++] = state;
+    }
+
+    // enter top down from below the lca to the target
+    for (uint8_t i = target_depth; i > 0; i--)
+    {
+        if (target_chain[i - 1] == lca)
+        {
+            transition->entry_count = 0;
+            continue;
+        }
+
+        transition->entry_path[transition->entry_count++] = target_chain[i - 1];
+    }
+
+    // then follow the initial substates down to a leaf
+    for (state = target->initial; state; state = state->initial)
+    {
+        transition->entry_path[transition->entry_count++] = state;
+    }
+
+    return OS_SUCCESS;
+}
+
+extern void HsmInit(Hsm_t* hsm, const HsmState_t* initial)
+{
+    hsm->initial = initial;
+    hsm->current = NULL;
+    hsm->pending = NULL;
+}
+
+extern OSStatus_t HsmStart(Hsm_t* hsm, void* instance_data)
+{
+    const HsmState_t* chain[HSM_MAX_DEPTH];
+    uint8_t           depth = 0;
+
+    if (!hsm || !hsm->initial || HSM_MAX_DEPTH < HsmLeafDepth(hsm->initial))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    // ancestors of the initial state are entered first
+    for (const HsmState_t* state = hsm->initial; state; state = state->parent)
+    {
+        chain[depth++] = state;
+    }
+
+    while (depth > 0)
+    {
+        hsm->current = chain[--depth];
+        Enter(hsm, hsm->current, instance_data);
+    }
+
+    // initial substates
+    while (hsm->current->initial)
+    {
+        hsm->current = hsm->current->initial;
+        Enter(hsm, hsm->current, instance_data);
+    }
+
+    return OS_SUCCESS;
+}
+
+extern bool HsmDispatch(Hsm_t* hsm, Message_t* msg, void* instance_data)
+{
+    bool handled = false;
+
+    hsm->pending = NULL;
+
+    // bubble up until a state handles the message
+    for (const HsmState_t* state = hsm->current; state; state = state->parent)
+    {
+        if (state->on_Message && state->on_Message(hsm, msg, instance_data))
+        {
+            handled = true;
+            break;
+        }
+    }
+
+    const HsmTransition_t* transition = hsm->pending;
+
+    if (!transition)
+    {
+        return handled;
+    }
+
+    hsm->pending = NULL;
+
+    // substates of the source are not part of the cached path
+    for (const HsmState_t* state = hsm->current; state && state != transition->source;
+         state = state->parent)
+    {
+        Exit(hsm, state, instance_data);
+    }
+
+    for (uint8_t i = 0; i < transition->exit_count; i++)
+    {
+        Exit(hsm, transition->exit_path[i], instance_data);
+    }
+
+    for (uint8_t i = 0; i < transition->entry_count; i++)
+    {
+        hsm->current = transition->entry_path[i];
+        Enter(hsm, hsm->current, instance_data);
+    }
+
+    return handled;
+}
+
+extern OSStatus_t HsmTransition(Hsm_t* hsm, const HsmTransition_t* transition)
+{
+    // the exit path starts at the source, the states below it are exited first
+    if (!HsmIsIn(hsm, transition->source))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    hsm->pending = transition;
+
+    return OS_SUCCESS;
+}
+
+extern bool HsmIsIn(Hsm_t* hsm, const HsmState_t* state)
+{
+    for (const HsmState_t* s = hsm->current; s; s = s->parent)
+    {
+        if (s == state)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif // OS_CFG_HSM
@@ -3,18 +3,43 @@
  */
 
 #include "inc/os.h"
+#include "inc/os_call.h"
+#include "inc/os_defer.h"
+#include "inc/os_job.h"
 #include "inc/os_msg.h"
+#include "inc/os_port.h"
+#include "inc/os_proxy.h"
+#include "inc/os_time.h"
 
 //! internal OS instance pointer
 static OS_t* os_ptr;
 
 //! queue head pointers
-static ActiveObject_t*     activated_ao = NULL;
+static ActiveObject_t* activated_ao = NULL;
+#if OS_CFG_TIMED_EVENTS
 static TimedEventSimple_t* timed_events = NULL;
+#endif
+
+//! AO whose handler is running, NULL outside AOs
+static ActiveObject_t* current_ao = NULL;
+
+//! a deferred call is running, it isn't preempted either
+static bool deferred_running = false;
+
+#if OS_CFG_TIMED_EVENTS
+//! timed event wakeup accounting
+static TimedEventStats_t timed_event_stats = {0, 0, 0};
+#endif
 
 static void SchedulerActivateNextAO();
+static void ActiveObjectDeliver(ActiveObject_t* ao, Message_t* msg);
+static void ActiveObjectDrain(ActiveObject_t* ao);
+#if OS_CFG_TIMED_EVENTS
 static void SchedulerProcessTimedEvents();
 static void RemoveTimedEvent(TimedEventSimple_t** head, TimedEventSimple_t** trail);
+static int32_t TimedEventRemaining(TimedEventSimple_t* event, uint32_t now);
+static void TimedEventReleased(TimedEventSimple_t* event, uint32_t now);
+#endif
 
 OS_t* OSGetOS()
 {
@@ -36,28 +61,44 @@ void KernelInit(OS_t* os, OSCallbacksCfg_t* callback_cfg)
     // set internal pointer
     os_ptr = os;
 
+    OSCallInit();
+    DeferInit();
+
+#if OS_CFG_HOOK_INIT
     // hook
     if (os_ptr->on_Init)
     {
         os->on_Init();
     }
+#endif
 }
 
 /**
  * @brief Runs on system tick (1ms)
  *
  */
-__attribute__((__interrupt__)) void SysTick_Handler()
+OS_INTERRUPT void SysTick_Handler()
 {
     OS_ISR_ENTER(os_ptr);
 
+    os_ptr->time++;
+
+    // often enough to catch every wrap of the port's cycle counter
+    OSGetCycles();
+
+#if OS_CFG_TIMED_EVENTS
     SchedulerProcessTimedEvents();
+#endif
+    OSCallProcessTimeouts();
+    ProxyRetryFlushes();
 
+#if OS_CFG_HOOK_SYSTICK
     // hook
     if (os_ptr->on_SysTick)
     {
         os_ptr->on_SysTick();
     }
+#endif
 
     OS_ISR_EXIT(os_ptr);
 }
@@ -67,17 +108,85 @@ extern uint32_t OSGetTime()
     return os_ptr->time;
 }
 
+#if OS_CFG_TIMED_EVENTS
+/**
+ * @brief Time until the event is due
+ *
+ * @param event
+ * @param now
+ * @return int32_t (ms), 0 or less if due
+ */
+static int32_t TimedEventRemaining(TimedEventSimple_t* event, uint32_t now)
+{
+    if (TIMED_EVENT_PERIODIC_ABSOLUTE_TYPE == event->type)
+    {
+        return (int32_t)(event->release - now);
+    }
+
+    return (int32_t)(event->period - event->count);
+}
+
+/**
+ * @brief Schedules the next release of an absolute event after a dispatch
+ *
+ * @param event
+ * @param now
+ */
+static void TimedEventReleased(TimedEventSimple_t* event, uint32_t now)
+{
+    int32_t lateness = (int32_t)(now - event->release);
+
+    // a period or more late, one overrun per release that wasn't dispatched in its period
+    if (lateness >= (int32_t)event->period)
+    {
+        uint32_t missed = (uint32_t)lateness / event->period;
+
+        if (event->skip_missed)
+        {
+            // dispatched for the latest release due, the ones before it are skipped
+            event->release += missed * event->period;
+            lateness -= (int32_t)(missed * event->period);
+            event->timing.overruns += missed;
+        }
+        else
+        {
+            // dispatched for this one, the ones after it follow on the next ticks
+            event->timing.overruns++;
+        }
+    }
+
+    // early dispatches (slack) count as jitter too
+    uint32_t jitter = (lateness < 0) ? (uint32_t)-lateness : (uint32_t)lateness;
+
+    event->timing.releases++;
+    event->timing.jitter_sum += jitter;
+
+    if (jitter > event->timing.jitter_max)
+    {
+        event->timing.jitter_max = jitter;
+    }
+
+    // from the ideal release time, not from now
+    event->release += event->period;
+}
+
 /**
  * @brief Updates timed events and dispatches if necessary
  *
+ * Events within their slack of expiring are dispatched early if another event
+ * is due on this tick, so they share one wakeup.
+ *
  */
 static void SchedulerProcessTimedEvents()
 {
     // list traversal head, trail is prev
     TimedEventSimple_t* head = timed_events;
     TimedEventSimple_t* trail = NULL;
+    bool                wakeup = false;
+    bool                dispatched = false;
+    uint32_t            now = os_ptr->time;
 
-    // for each item in list
+    // count and find out if anything is due
     while (head)
     {
         if (!head->active)
@@ -87,12 +196,45 @@ static void SchedulerProcessTimedEvents()
         }
 
         head->count++;
+        wakeup = wakeup || (TimedEventRemaining(head, now) <= 0);
+
+        trail = head;
+        head = head->next;
+    }
+
+    if (!wakeup)
+    {
+        return;
+    }
+
+    head = timed_events;
+    trail = NULL;
+
+    // for each item in list
+    while (head)
+    {
+        int32_t remaining = TimedEventRemaining(head, now);
+        bool    is_due = remaining <= 0;
 
-        // dispatch if time is up
-        if (head->count >= head->period)
+        // dispatch if time is up or close enough, a full queue retries on the next tick
+        if ((is_due || remaining <= (int32_t)head->slack) &&
+            MSG_Q_SUCCESS == MsgQueuePutTimed(head->dest, (void*)head->message))
         {
-            MsgQueuePut(head->dest, (void*)head->message);
-            head->count = 0;
+            // early, the next period counts from when it was due so the phase doesn't drift
+            head->count = is_due ? 0 : (uint32_t)-remaining;
+            dispatched = true;
+
+            if (TIMED_EVENT_PERIODIC_ABSOLUTE_TYPE == head->type)
+            {
+                TimedEventReleased(head, now);
+            }
+
+            timed_event_stats.dispatches++;
+
+            if (!is_due)
+            {
+                timed_event_stats.coalesced++;
+            }
 
             // remove single event from queue
             if (TIMED_EVENT_SINGLE_TYPE == head->type)
@@ -105,6 +247,12 @@ static void SchedulerProcessTimedEvents()
         trail = head;
         head = head->next;
     }
+
+    // a tick whose puts all failed didn't wake anything
+    if (dispatched)
+    {
+        timed_event_stats.wakeups++;
+    }
 }
 
 static void RemoveTimedEvent(TimedEventSimple_t** head, TimedEventSimple_t** trail)
@@ -139,14 +287,38 @@ extern void TimedEventSimpleCreate(TimedEventSimple_t* event, ActiveObject_t* de
     event->type = type;
     event->dest = dest;
     event->count = 0;
+    event->slack = 0;
+    event->release = 0;
+    event->skip_missed = false;
+    event->timing = (TimedEventTiming_t){0, 0, 0, 0};
 
     event->active = true;
 }
 
+extern void TimedEventAbsoluteCreate(TimedEventSimple_t* event, ActiveObject_t* dest, void* msg,
+                                     uint32_t period, bool skip_missed)
+{
+    TimedEventSimpleCreate(event, dest, msg, period, TIMED_EVENT_PERIODIC_ABSOLUTE_TYPE);
+    event->skip_missed = skip_missed;
+}
+
+extern void TimedEventSetSlack(TimedEventSimple_t* event, uint32_t slack)
+{
+    event->slack = slack;
+}
+
+extern void SchedulerGetTimedEventStats(TimedEventStats_t* stats)
+{
+    DISABLE_INTERRUPTS();
+    *stats = timed_event_stats;
+    ENABLE_INTERRUPTS();
+}
+
 extern void SchedulerAddTimedEvent(TimedEventSimple_t* event)
 {
     // reset count
     event->count = 0;
+    event->release = os_ptr->time + event->period;
 
     TimedEventSimple_t* head = timed_events;
 
@@ -173,6 +345,7 @@ extern void SchedulerAddTimedEvent(TimedEventSimple_t* event)
     // set list head pointer
     timed_events = event;
 }
+#endif // OS_CFG_TIMED_EVENTS
 
 extern void ActiveObjectCreate(ActiveObject_t* ao, uint8_t priority, MessageQueue_t* queue,
                                EventHandler_f handler, uint8_t id)
@@ -182,28 +355,65 @@ extern void ActiveObjectCreate(ActiveObject_t* ao, uint8_t priority, MessageQueu
     ao->state = AO_WAITING;
     ao->msg_queue = queue;
     ao->handler = handler;
+    ao->event_flags = 0;
+#if OS_CFG_DISPATCH
+    ao->dispatch = NULL;
+#endif
+#if OS_CFG_DIRECT
+    ao->direct = false;
+#endif
+#if OS_CFG_PROXY
+    ao->proxy = NULL;
+#endif
 
     ao->next = NULL;
     ao->prev = NULL;
     ao->id = id;
 }
 
+#if OS_CFG_DISPATCH
+extern void ActiveObjectSetDispatch(ActiveObject_t* ao, const MessageDispatchTable_t* table)
+{
+    ao->dispatch = table;
+}
+#endif
+
+#if OS_CFG_DIRECT
+extern void ActiveObjectSetDirect(ActiveObject_t* ao, bool enable)
+{
+    ao->direct = enable;
+}
+#endif
+
 extern void SchedulerRun()
 {
     while (true)
     {
+        // spare cycles go to background jobs first, AOs preempt them as usual
+        JobRunIdle();
+
+#if OS_CFG_HOOK_IDLE
         // idle loop
         if (os_ptr->on_Idle)
         {
             os_ptr->on_Idle();
         }
+#endif
     }
 }
 
 extern int Schedule()
 {
-    // if there's something higher in priority than what's current
-    if (activated_ao->priority < os_ptr->current_prio)
+    // like running AOs, running deferred calls finish first
+    if (deferred_running)
+    {
+        return 0;
+    }
+
+    // if there's something higher in priority than what's current. Deferred calls don't preempt
+    // either, only start them from idle, SchedulerActivateAO takes them between AOs
+    if ((activated_ao && activated_ao->priority < os_ptr->current_prio) ||
+        (0xFF == os_ptr->current_prio && OS_DEFER_NONE != DeferHighestPriority()))
     {
         return 1;
     }
@@ -213,54 +423,216 @@ extern int Schedule()
     }
 }
 
+/**
+ * @brief Hands a message to the AO's handler or dispatch table
+ *
+ * @param ao
+ * @param msg
+ */
+static void ActiveObjectDeliver(ActiveObject_t* ao, Message_t* msg)
+{
+#ifdef OS_TRACE_ENABLED
+    os_ptr->on_DebugPrint(ao->id, msg->id, DEBUG_PRINT_IS_HANDLE);
+#endif
+
+#if OS_CFG_DISPATCH
+    if (ao->dispatch)
+    {
+        // straight into the handler registered for this id
+        EventHandler_f handler = MessageDispatchLookup(ao->dispatch, msg->id);
+
+        if (handler)
+        {
+            handler(msg);
+        }
+
+        return;
+    }
+#endif
+
+    ao->handler(msg);
+}
+
+/**
+ * @brief Hands all queued messages and pending flags to the AO
+ *
+ * @param ao
+ */
+static void ActiveObjectDrain(ActiveObject_t* ao)
+{
+    // empty all messages in queue
+    while (!MsgQueueIsEmpty(ao->msg_queue))
+    {
+        Message_t* msg = (Message_t*)MsgQueueGet(ao);
+
+        ActiveObjectDeliver(ao, msg);
+        MsgQueueRelease(ao->msg_queue);
+    }
+
+    // one notification for all flags set since the last one
+    uint32_t flags = __atomic_exchange_n(&ao->event_flags, 0, __ATOMIC_ACQ_REL);
+
+    if (flags)
+    {
+        EventFlagsMessage_t flags_msg = {
+            .base = {.id = OS_EVENT_FLAGS_MSG_ID, .msg_size = sizeof(EventFlagsMessage_t)},
+            .flags = flags};
+
+        ActiveObjectDeliver(ao, &flags_msg.base);
+    }
+}
+
 extern void SchedulerActivateAO()
 {
+    DeferredCall_t call;
+
     // run all ready tasks
-    while (activated_ao)
+    while (true)
     {
+        // deferred calls of the same or higher priority run before the next AO
+        if (DeferTake(activated_ao ? activated_ao->priority : OS_DEFER_NONE, &call))
+        {
+            os_ptr->current_prio = call.priority;
+            deferred_running = true;
+
+            call.fn(call.arg);
+
+            deferred_running = false;
+            continue;
+        }
+
+        // checked and going idle without being interrupted, so new work gets scheduled
+        DISABLE_INTERRUPTS();
+
+        if (!activated_ao)
+        {
+            if (OS_DEFER_NONE == DeferHighestPriority())
+            {
+                os_ptr->current_prio = 0xFF;
+                ENABLE_INTERRUPTS();
+                break;
+            }
+
+            ENABLE_INTERRUPTS();
+            continue;
+        }
+
+        ENABLE_INTERRUPTS();
+
         activated_ao->state = AO_ACTIVE;
 
         // set the current execution priority
         os_ptr->current_prio = activated_ao->priority;
+        current_ao = activated_ao;
+
+        ActiveObjectDrain(activated_ao);
+        current_ao = NULL;
+
+        // an ISR can't readify an active AO, so check for new work and
+        // go back to waiting without being interrupted
+        DISABLE_INTERRUPTS();
 
-        // empty all messages in queue
-        while (!MsgQueueIsEmpty(activated_ao->msg_queue))
+        if (MsgQueueIsEmpty(activated_ao->msg_queue) && 0 == activated_ao->event_flags)
         {
-            Message_t* msg = (Message_t*)MsgQueueGet(activated_ao);
+            // get next
+            SchedulerActivateNextAO();
+        }
 
-#ifdef OS_TRACE_ENABLED
-            os_ptr->on_DebugPrint(activated_ao->id, msg->id, DEBUG_PRINT_IS_HANDLE);
-#endif
+        ENABLE_INTERRUPTS();
+    }
+}
+
+#if OS_CFG_DIRECT
+extern bool SchedulerDispatchDirect(ActiveObject_t* ao, Message_t* msg)
+{
+    bool done = false;
+
+    DISABLE_INTERRUPTS();
+
+    // only from a running AO of lower priority, to an idle AO that would run next anyway. Ready
+    // AOs and deferred calls of its own priority were first and run before it
+    if (OSPortInIsr() || !activated_ao || AO_ACTIVE != activated_ao->state || deferred_running ||
+        ao->priority >= os_ptr->current_prio || AO_WAITING != ao->state ||
+        !MsgQueueIsEmpty(ao->msg_queue) || 0 != ao->event_flags ||
+        (activated_ao->next && activated_ao->next->priority <= ao->priority) ||
+        DeferHighestPriority() <= ao->priority)
+    {
+        ENABLE_INTERRUPTS();
+        return false;
+    }
+
+    // not in the ready list, posts made while it runs stay queued until drained below
+    uint8_t         sender_prio = os_ptr->current_prio;
+    ActiveObject_t* sender = current_ao;
+
+    ao->state = AO_ACTIVE;
+    os_ptr->current_prio = ao->priority;
+    current_ao = ao;
+
+    ENABLE_INTERRUPTS();
+
+    ActiveObjectDeliver(ao, msg);
+
+    while (!done)
+    {
+        ActiveObjectDrain(ao);
+
+        DISABLE_INTERRUPTS();
+
+        done = MsgQueueIsEmpty(ao->msg_queue) && 0 == ao->event_flags;
 
-            activated_ao->handler(msg);
+        if (done)
+        {
+            ao->state = AO_WAITING;
+            os_ptr->current_prio = sender_prio;
+            current_ao = sender;
         }
 
-        // get next
-        SchedulerActivateNextAO();
+        ENABLE_INTERRUPTS();
     }
+
+    return true;
 }
+#endif
 
-extern void SchedulerAddReady(ActiveObject_t* ao)
+extern bool SchedulerHasReady()
+{
+    return NULL != activated_ao || OS_DEFER_NONE != DeferHighestPriority();
+}
+
+extern ActiveObject_t* SchedulerGetCurrentAO()
+{
+    return current_ao;
+}
+
+extern OSStatus_t ActiveObjectSetFlags(ActiveObject_t* ao, uint32_t flags)
 {
-    // just add to list if already running, no need to requeue
-    if (AO_ACTIVE == ao->state || activated_ao == ao)
+    // never runs here, flags aren't sent to the remote AO
+    if (AO_IS_PROXY(ao))
     {
-        return;
+        return OS_INVALID_ARGUMENT;
     }
 
-    // extract from list and reinsert to get correct priority (something else might be running too)
-    if (AO_READY == ao->state)
+    // flags already pending means the AO has been readied, nothing else to do
+    if (0 != __atomic_fetch_or(&ao->event_flags, flags, __ATOMIC_ACQ_REL))
     {
-        ao->prev->next = ao->next;
-        ao->next->prev = ao->prev;
-        ao->next = NULL;
-        ao->prev = NULL;
+        return OS_SUCCESS;
     }
 
-    // to make things simple, don't interrupt current AO process, add
-    // new ready task right after current running task
-    // either prio is higher or lower than current
-    // if higher, schedule right after, else, schedule where needed
+    DISABLE_INTERRUPTS();
+    SchedulerAddReady(ao);
+    ENABLE_INTERRUPTS();
+
+    return OS_SUCCESS;
+}
+
+extern void SchedulerAddReady(ActiveObject_t* ao)
+{
+    // running, or ready and already in place behind the AOs of its priority readied before it
+    if (AO_WAITING != ao->state || activated_ao == ao)
+    {
+        return;
+    }
 
     // traversal pointers
     ActiveObject_t* temp = activated_ao;
@@ -273,8 +645,15 @@ extern void SchedulerAddReady(ActiveObject_t* ao)
     }
     else
     {
-        // find position
-        while (temp && temp->priority < ao->priority)
+        // don't want to interrupt the current AO, whatever its priority it goes somewhere after
+        if (AO_ACTIVE == activated_ao->state)
+        {
+            parent = activated_ao;
+            temp = activated_ao->next;
+        }
+
+        // find position, after the AOs of the same priority so they run in the order readied
+        while (temp && temp->priority <= ao->priority)
         {
             parent = temp;
             temp = temp->next;
@@ -282,42 +661,22 @@ extern void SchedulerAddReady(ActiveObject_t* ao)
 
         if (!parent)
         {
-            // start of the list
-
-            // insert after current ao if active, if READY, insert before
-            if (activated_ao->state == AO_ACTIVE)
-            {
-                // don't want to interrupt so put it after
-                if (activated_ao->next)
-                {
-                    activated_ao->next->prev = ao;
-                }
-
-                ao->next = activated_ao->next;
-                ao->prev = activated_ao;
-                activated_ao->next = ao;
-            }
-            else
-            {
-                // insert before
-                ao->next = activated_ao;
-                activated_ao->prev = ao;
-                activated_ao = ao;
-            }
-        }
-        else if (!temp)
-        {
-            // at end
-            parent->next = ao;
-            ao->prev = parent;
+            // insert before the list head
+            ao->next = activated_ao;
+            activated_ao->prev = ao;
+            activated_ao = ao;
         }
         else
         {
-            // list middle somewhere
+            // list middle somewhere or at end
             parent->next = ao;
             ao->prev = parent;
             ao->next = temp;
-            temp->prev = ao;
+
+            if (temp)
+            {
+                temp->prev = ao;
+            }
         }
     }
 
@@ -333,7 +692,11 @@ static void SchedulerActivateNextAO()
     // extract, break all connections
     ActiveObject_t* prev_activated = activated_ao;
     activated_ao = activated_ao->next;
-    activated_ao->prev = NULL;
+
+    if (activated_ao)
+    {
+        activated_ao->prev = NULL;
+    }
 
     prev_activated->next = NULL;
     prev_activated->prev = NULL;
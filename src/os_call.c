@@ -0,0 +1,266 @@
+/**
+ * @file os_call.c
+ */
+
+#include "inc/os_call.h"
+
+#if OS_CFG_CALL
+
+static CallSlot_t* FindSlot(CallToken_t token);
+static void        FreeSlot(uint8_t index);
+static void        UpdateNextDeadline();
+
+//! pending call table
+static CallSlot_t call_table[OS_CALL_TABLE_SIZE];
+
+//! head of the free slot list
+static uint8_t free_head = OS_CALL_SLOT_NONE;
+
+//! calls waiting with a timeout
+static uint8_t timed_count = 0;
+
+//! earliest deadline of the pending calls, the table is only scanned once it has passed
+static uint32_t next_deadline = 0;
+
+//! token layout: generation above the slot index
+#define CALL_TOKEN(generation, index) (((CallToken_t)(generation) << 8U) | (index))
+#define CALL_TOKEN_INDEX(token)       ((uint8_t)((token) & 0xFFU))
+#define CALL_TOKEN_GENERATION(token)  ((uint16_t)((token) >> 8U))
+
+extern void OSCallInit()
+{
+    for (uint8_t i = 0; i < OS_CALL_TABLE_SIZE; i++)
+    {
+        call_table[i].caller = NULL;
+        call_table[i].pending = false;
+        call_table[i].has_timeout = false;
+        call_table[i].generation = 0;
+        call_table[i].next_free = (i + 1 < OS_CALL_TABLE_SIZE) ? i + 1 : OS_CALL_SLOT_NONE;
+    }
+
+    free_head = 0;
+    timed_count = 0;
+}
+
+/**
+ * @brief Token -> slot, NULL if the token is stale. Call from a critical section.
+ *
+ * @param token
+ * @return CallSlot_t*
+ */
+static CallSlot_t* FindSlot(CallToken_t token)
+{
+    uint8_t index = CALL_TOKEN_INDEX(token);
+
+    if (index >= OS_CALL_TABLE_SIZE || !call_table[index].pending ||
+        call_table[index].generation != CALL_TOKEN_GENERATION(token))
+    {
+        return NULL;
+    }
+
+    return &call_table[index];
+}
+
+/**
+ * @brief Returns a slot to the free list. Call from a critical section.
+ *
+ * @param index
+ */
+static void FreeSlot(uint8_t index)
+{
+    CallSlot_t* slot = &call_table[index];
+
+    if (slot->has_timeout)
+    {
+        timed_count--;
+    }
+
+    slot->pending = false;
+    slot->has_timeout = false;
+    slot->caller = NULL;
+    slot->next_free = free_head;
+    free_head = index;
+}
+
+extern CallToken_t OSCallRequest(ActiveObject_t* caller, ActiveObject_t* callee,
+                                 CallMessage_t* request, uint32_t timeout_ms)
+{
+    DISABLE_INTERRUPTS();
+
+    if (OS_CALL_SLOT_NONE == free_head)
+    {
+        ENABLE_INTERRUPTS();
+        return OS_CALL_TOKEN_NONE;
+    }
+
+    uint8_t     index = free_head;
+    CallSlot_t* slot = &call_table[index];
+
+    free_head = slot->next_free;
+
+    // generation 0 is skipped so no token is OS_CALL_TOKEN_NONE
+    if (0 == ++slot->generation)
+    {
+        slot->generation = 1;
+    }
+
+    slot->caller = caller;
+    slot->pending = true;
+    slot->has_timeout = 0 != timeout_ms;
+    slot->deadline = OSGetTime() + timeout_ms;
+
+    if (slot->has_timeout)
+    {
+        if (0 == timed_count++ || (int32_t)(slot->deadline - next_deadline) < 0)
+        {
+            next_deadline = slot->deadline;
+        }
+    }
+
+    CallToken_t token = CALL_TOKEN(slot->generation, index);
+
+    ENABLE_INTERRUPTS();
+
+    // registered first, the callee may reply before MsgQueuePut returns
+    request->token = token;
+
+    if (MSG_Q_SUCCESS != MsgQueuePut(callee, request))
+    {
+        OSCallCancel(token);
+        return OS_CALL_TOKEN_NONE;
+    }
+
+    return token;
+}
+
+extern OSStatus_t OSCallReply(const CallMessage_t* request, CallMessage_t* reply)
+{
+    DISABLE_INTERRUPTS();
+
+    CallSlot_t* slot = FindSlot(request->token);
+
+    if (!slot)
+    {
+        ENABLE_INTERRUPTS();
+        return OS_INVALID_ARGUMENT;
+    }
+
+    // complete before posting, a timeout can't be sent for it anymore
+    ActiveObject_t* caller = slot->caller;
+
+    FreeSlot(CALL_TOKEN_INDEX(request->token));
+
+    ENABLE_INTERRUPTS();
+
+    reply->token = request->token;
+
+    if (MSG_Q_SUCCESS != MsgQueuePut(caller, reply))
+    {
+        return OS_ERROR;
+    }
+
+    return OS_SUCCESS;
+}
+
+extern bool OSCallCancel(CallToken_t token)
+{
+    bool cancelled = false;
+
+    DISABLE_INTERRUPTS();
+
+    if (FindSlot(token))
+    {
+        FreeSlot(CALL_TOKEN_INDEX(token));
+        cancelled = true;
+    }
+
+    ENABLE_INTERRUPTS();
+
+    return cancelled;
+}
+
+extern bool OSCallIsPending(CallToken_t token)
+{
+    DISABLE_INTERRUPTS();
+    bool pending = NULL != FindSlot(token);
+    ENABLE_INTERRUPTS();
+
+    return pending;
+}
+
+/**
+ * @brief Recomputes the earliest deadline. Call from a critical section.
+ *
+ */
+static void UpdateNextDeadline()
+{
+    bool found = false;
+
+    for (uint8_t i = 0; i < OS_CALL_TABLE_SIZE; i++)
+    {
+        CallSlot_t* slot = &call_table[i];
+
+        if (slot->pending && slot->has_timeout &&
+            (!found || (int32_t)(slot->deadline - next_deadline) < 0))
+        {
+            next_deadline = slot->deadline;
+            found = true;
+        }
+    }
+}
+
+extern void OSCallProcessTimeouts()
+{
+    uint32_t now = OSGetTime();
+
+    // nothing can expire before the earliest deadline
+    if (0 == timed_count || (int32_t)(now - next_deadline) < 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < OS_CALL_TABLE_SIZE; i++)
+    {
+        CallSlot_t*   slot = &call_table[i];
+        CallMessage_t timeout = {
+            .base = {.id = OS_CALL_TIMEOUT_MSG_ID, .msg_size = sizeof(CallMessage_t)},
+            .token = OS_CALL_TOKEN_NONE};
+
+        DISABLE_INTERRUPTS();
+
+        if (slot->pending && slot->has_timeout && (int32_t)(now - slot->deadline) >= 0)
+        {
+            // stale from here on, a racing reply is rejected
+            slot->pending = false;
+            timeout.token = CALL_TOKEN(slot->generation, i);
+        }
+
+        ENABLE_INTERRUPTS();
+
+        if (OS_CALL_TOKEN_NONE == timeout.token)
+        {
+            continue;
+        }
+
+        bool posted = MSG_Q_SUCCESS == MsgQueuePut(slot->caller, &timeout);
+
+        DISABLE_INTERRUPTS();
+
+        if (posted)
+        {
+            FreeSlot(i);
+        }
+        else
+        {
+            // caller's queue is full, retry on the next tick
+            slot->pending = true;
+        }
+
+        ENABLE_INTERRUPTS();
+    }
+
+    DISABLE_INTERRUPTS();
+    UpdateNextDeadline();
+    ENABLE_INTERRUPTS();
+}
+#endif // OS_CFG_CALL
@@ -0,0 +1,125 @@
+/**
+ * @file os_coro.c
+ */
+
+#include "inc/os_coro.h"
+
+#if OS_CFG_CORO
+
+static void CancelTimeout(Coroutine_t* co);
+
+extern void CoroutineTimerInit(CoroutineTimer_t* timer, ActiveObject_t* ao,
+                               uint32_t timeout_msg_id)
+{
+    timer->timeout_msg.base.id = timeout_msg_id;
+    timer->timeout_msg.base.msg_size = sizeof(DataMessage_t);
+    timer->timeout_msg.timestamp = 0;
+    timer->timeout_msg.data = 0;
+
+    timer->event.dest = ao;
+    timer->event.active = false;
+    timer->event.next = NULL;
+
+    timer->owner = NULL;
+    timer->generation = 0;
+}
+
+extern void CoroutineInit(Coroutine_t* co, CoroutineTimer_t* timer)
+{
+    co->line = 0;
+    co->timed_out = false;
+    co->wait_id = CORO_WAIT_NONE;
+    co->timer = timer;
+}
+
+extern void CoroutineReset(Coroutine_t* co)
+{
+    CancelTimeout(co);
+
+    co->line = 0;
+    co->timed_out = false;
+    co->wait_id = CORO_WAIT_NONE;
+}
+
+extern bool CoroutineIsDone(Coroutine_t* co)
+{
+    return CORO_LINE_DONE == co->line;
+}
+
+/**
+ * @brief Stops the timer if it runs for co, a timeout that might already be queued no longer has
+ *        an owner and is ignored
+ *
+ * @param co
+ */
+static void CancelTimeout(Coroutine_t* co)
+{
+    CoroutineTimer_t* timer = co->timer;
+
+    if (timer->owner != co)
+    {
+        return;
+    }
+
+    if (timer->event.active)
+    {
+        TimedEventDisable(&timer->event);
+    }
+
+    timer->owner = NULL;
+}
+
+extern void CoroutineWait(Coroutine_t* co, uint32_t wait_id, uint32_t timeout_ms)
+{
+    CoroutineTimer_t* timer = co->timer;
+
+    co->wait_id = wait_id;
+    co->timed_out = false;
+
+    if (0 == timeout_ms)
+    {
+        return;
+    }
+
+    // message is copied into the queue on dispatch, so the generation is captured then
+    timer->generation++;
+    timer->timeout_msg.data = timer->generation;
+    timer->timeout_msg.timestamp = OSGetTime();
+    timer->owner = co;
+
+    TimedEventSimpleCreate(&timer->event, timer->event.dest, &timer->timeout_msg, timeout_ms,
+                           TIMED_EVENT_SINGLE_TYPE);
+    SchedulerAddTimedEvent(&timer->event);
+}
+
+extern bool CoroutineWaitDone(Coroutine_t* co, Message_t* msg)
+{
+    CoroutineTimer_t* timer = co->timer;
+
+    if (timer->timeout_msg.base.id == msg->id)
+    {
+        // only the timeout of the current await of this coroutine counts
+        if (timer->owner != co || ((DataMessage_t*)msg)->data != timer->generation)
+        {
+            return false;
+        }
+
+        timer->event.active = false;
+        timer->owner = NULL;
+        co->timed_out = true;
+        co->wait_id = CORO_WAIT_NONE;
+
+        return true;
+    }
+
+    if (CORO_WAIT_NONE == co->wait_id || co->wait_id != msg->id)
+    {
+        return false;
+    }
+
+    CancelTimeout(co);
+    co->wait_id = CORO_WAIT_NONE;
+
+    return true;
+}
+#endif // OS_CFG_CORO
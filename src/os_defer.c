@@ -0,0 +1,109 @@
+/**
+ * @file os_defer.c
+ */
+
+#include "inc/os_defer.h"
+
+#if OS_CFG_DEFER
+
+//! call pool
+static DeferredCall_t defer_pool[OS_DEFER_POOL_SIZE];
+
+//! pending calls, ordered by priority, FIFO within a priority
+static uint8_t defer_head = OS_DEFER_NONE;
+
+//! unused entries
+static uint8_t defer_free = OS_DEFER_NONE;
+
+//! calls rejected
+static uint32_t defer_dropped = 0;
+
+extern void DeferInit()
+{
+    for (uint8_t i = 0; i < OS_DEFER_POOL_SIZE; i++)
+    {
+        defer_pool[i].next = (i + 1 < OS_DEFER_POOL_SIZE) ? i + 1 : OS_DEFER_NONE;
+    }
+
+    defer_free = 0;
+    defer_head = OS_DEFER_NONE;
+    defer_dropped = 0;
+}
+
+extern OSStatus_t DeferCall(DeferredCall_f fn, void* arg, uint8_t priority)
+{
+    // would look like an empty list to the scheduler and never run
+    if (OS_DEFER_NONE == priority)
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    DISABLE_INTERRUPTS();
+
+    if (OS_DEFER_NONE == defer_free)
+    {
+        defer_dropped++;
+        ENABLE_INTERRUPTS();
+        return OS_MEMORY_BLOCK_FULL;
+    }
+
+    uint8_t         index = defer_free;
+    DeferredCall_t* call = &defer_pool[index];
+
+    defer_free = call->next;
+
+    call->fn = fn;
+    call->arg = arg;
+    call->priority = priority;
+
+    // after every call of the same or higher priority
+    uint8_t* link = &defer_head;
+
+    while (OS_DEFER_NONE != *link && defer_pool[*link].priority <= priority)
+    {
+        link = &defer_pool[*link].next;
+    }
+
+    call->next = *link;
+    *link = index;
+
+    ENABLE_INTERRUPTS();
+
+    return OS_SUCCESS;
+}
+
+extern uint8_t DeferHighestPriority()
+{
+    uint8_t head = defer_head;
+
+    return (OS_DEFER_NONE == head) ? OS_DEFER_NONE : defer_pool[head].priority;
+}
+
+extern bool DeferTake(uint8_t limit, DeferredCall_t* call)
+{
+    DISABLE_INTERRUPTS();
+
+    uint8_t index = defer_head;
+
+    if (OS_DEFER_NONE == index || defer_pool[index].priority > limit)
+    {
+        ENABLE_INTERRUPTS();
+        return false;
+    }
+
+    *call = defer_pool[index];
+
+    defer_head = defer_pool[index].next;
+    defer_pool[index].next = defer_free;
+    defer_free = index;
+
+    ENABLE_INTERRUPTS();
+
+    return true;
+}
+
+extern uint32_t DeferDropped()
+{
+    return defer_dropped;
+}
+#endif // OS_CFG_DEFER
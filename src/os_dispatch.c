@@ -0,0 +1,23 @@
+/**
+ * @file os_dispatch.c
+ */
+
+#include "inc/os_dispatch.h"
+#include "inc/os_msg.h"
+
+#if OS_CFG_DISPATCH
+
+extern bool MessageDispatch(const MessageDispatchTable_t* table, Message_t* msg)
+{
+    EventHandler_f handler = MessageDispatchLookup(table, msg->id);
+
+    if (!handler)
+    {
+        return false;
+    }
+
+    handler(msg);
+
+    return true;
+}
+#endif // OS_CFG_DISPATCH
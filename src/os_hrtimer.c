@@ -0,0 +1,150 @@
+/**
+ * @file os_hrtimer.c
+ */
+
+#include "inc/os_time.h"
+#include "inc/os.h"
+#include "inc/os_port.h"
+
+#if OS_CFG_HRTIMER
+
+//! pending timers, earliest deadline first
+static HrTimer_t* hr_timers = NULL;
+
+static void RemoveTimer(HrTimer_t* timer);
+static void ArmHardware(uint64_t now);
+
+/**
+ * @brief Unlinks a timer, call with interrupts disabled
+ *
+ * @param timer
+ */
+static void RemoveTimer(HrTimer_t* timer)
+{
+    HrTimer_t** link = &hr_timers;
+
+    while (*link && *link != timer)
+    {
+        link = &(*link)->next;
+    }
+
+    if (*link)
+    {
+        *link = timer->next;
+    }
+
+    timer->next = NULL;
+    timer->active = false;
+}
+
+/**
+ * @brief Sets the hardware timer to the earliest deadline, call with interrupts disabled
+ *
+ * @param now current cycle count, read before disabling interrupts
+ */
+static void ArmHardware(uint64_t now)
+{
+    if (!hr_timers)
+    {
+        OSPortHrTimerCancel();
+        return;
+    }
+
+    uint64_t delay = (hr_timers->deadline > now) ? hr_timers->deadline - now : 1;
+
+    // far deadlines are reached in several steps
+    OSPortHrTimerSet(delay > 0xFFFFFFFFU ? 0xFFFFFFFFU : (uint32_t)delay);
+}
+
+extern void HrTimerStart(HrTimer_t* timer, ActiveObject_t* dest, void* msg, uint32_t delay_us)
+{
+    uint64_t now = OSGetCycles();
+    uint64_t deadline = now + OSTimeUsToCycles(delay_us);
+
+    DISABLE_INTERRUPTS();
+
+    if (timer->active)
+    {
+        RemoveTimer(timer);
+    }
+
+    timer->dest = dest;
+    timer->message = msg;
+    timer->deadline = deadline;
+    timer->active = true;
+
+    // insert by deadline
+    HrTimer_t** link = &hr_timers;
+
+    while (*link && (*link)->deadline <= deadline)
+    {
+        link = &(*link)->next;
+    }
+
+    timer->next = *link;
+    *link = timer;
+
+    // only the earliest deadline is on the hardware
+    if (hr_timers == timer)
+    {
+        ArmHardware(now);
+    }
+
+    ENABLE_INTERRUPTS();
+}
+
+extern void HrTimerStop(HrTimer_t* timer)
+{
+    uint64_t now = OSGetCycles();
+
+    DISABLE_INTERRUPTS();
+
+    if (timer->active)
+    {
+        bool was_first = (hr_timers == timer);
+
+        RemoveTimer(timer);
+
+        if (was_first)
+        {
+            ArmHardware(now);
+        }
+    }
+
+    ENABLE_INTERRUPTS();
+}
+
+extern void HrTimerProcess()
+{
+    uint64_t now = OSGetCycles();
+
+    // dispatch everything due
+    while (true)
+    {
+        DISABLE_INTERRUPTS();
+
+        HrTimer_t* timer = hr_timers;
+
+        if (!timer || timer->deadline > now)
+        {
+            ENABLE_INTERRUPTS();
+            break;
+        }
+
+        RemoveTimer(timer);
+
+        ENABLE_INTERRUPTS();
+
+        if (MSG_Q_SUCCESS != MsgQueuePut(timer->dest, timer->message))
+        {
+            timer->dropped++;
+        }
+    }
+
+    now = OSGetCycles();
+
+    DISABLE_INTERRUPTS();
+    ArmHardware(now);
+    ENABLE_INTERRUPTS();
+}
+#endif // OS_CFG_HRTIMER
@@ -0,0 +1,143 @@
+/**
+ * @file os_job.c
+ */
+
+#include "inc/os_job.h"
+
+#if OS_CFG_JOB
+
+static Job_t* NextJob();
+
+//! pending jobs
+static Job_t* jobs = NULL;
+
+//! last job run, jobs take turns
+static Job_t* last_job = NULL;
+
+extern void JobStart(Job_t* job, JobStep_f step, void* arg, uint32_t slice_us)
+{
+    job->step = step;
+    job->arg = arg;
+    job->slice_us = slice_us;
+    job->progress = 0;
+    job->steps = 0;
+    job->cycles = 0;
+    job->started = OSGetCycles();
+
+    // AOs preempt the idle loop walking the list
+    DISABLE_INTERRUPTS();
+
+    Job_t* head = jobs;
+
+    while (head && head != job)
+    {
+        head = head->next;
+    }
+
+    // restarted jobs stay where they are
+    if (!head)
+    {
+        job->next = jobs;
+        jobs = job;
+    }
+
+    job->active = true;
+
+    ENABLE_INTERRUPTS();
+}
+
+extern void JobCancel(Job_t* job)
+{
+    job->active = false;
+}
+
+extern bool JobsPending()
+{
+    return NULL != jobs;
+}
+
+/**
+ * @brief Unlinks finished jobs and picks the one after the last job run
+ *
+ * @return Job_t* NULL if none
+ */
+static Job_t* NextJob()
+{
+    Job_t* next = NULL;
+    Job_t* prev = NULL;
+
+    DISABLE_INTERRUPTS();
+
+    for (Job_t** link = &jobs; *link;)
+    {
+        if (!(*link)->active)
+        {
+            // the turn passes to the job after it, not back to the first one
+            if (last_job == *link)
+            {
+                last_job = prev;
+            }
+
+            *link = (*link)->next;
+            continue;
+        }
+
+        prev = *link;
+        link = &(*link)->next;
+    }
+
+    if (last_job && last_job->next)
+    {
+        next = last_job->next;
+    }
+    else
+    {
+        next = jobs;
+    }
+
+    last_job = next;
+
+    ENABLE_INTERRUPTS();
+
+    return next;
+}
+
+extern bool JobRunIdle()
+{
+    Job_t* job = NextJob();
+
+    if (!job)
+    {
+        return false;
+    }
+
+    uint64_t start = OSGetCycles();
+    uint64_t slice = OSTimeUsToCycles(job->slice_us);
+    uint64_t now;
+
+    do
+    {
+        if (job->step(job, job->arg))
+        {
+            job->active = false;
+        }
+
+        job->steps++;
+        now = OSGetCycles();
+    } while (job->active && !SchedulerHasReady() && now - start < slice);
+
+    job->cycles += now - start;
+
+    return true;
+}
+
+extern void JobGetStats(Job_t* job, JobStats_t* stats)
+{
+    uint64_t elapsed = OSGetCycles() - job->started;
+
+    stats->steps = job->steps;
+    stats->progress_permille =
+        job->total ? (uint32_t)(((uint64_t)job->progress * 1000U) / job->total) : 0;
+    stats->cpu_permille = elapsed ? (uint32_t)((job->cycles * 1000U) / elapsed) : 0;
+}
+#endif // OS_CFG_JOB
@@ -4,79 +4,182 @@
 
 #include "inc/os_mem.h"
 
-#define POOL_SIZE 512
+#if OS_CFG_MEM
 
-static uint8_t  pool[POOL_SIZE] = {0};
-static uint32_t used = 0;
+#if (OS_MEM_POOL_SIZE % MEMORY_BLOCK_32) || (OS_MEM_POOL_SIZE > MEMORY_BLOCK_32 * 64)
+    #error "OS_MEM_POOL_SIZE must be a multiple of 32 up to 2048, keys have a 6-bit index"
+#endif
 
-extern uint8_t* OSMemoryBlockNew(uint16_t* key, BlockSize_t size, OSStatus_t* status)
-{
-    *key = 0;
-    uint8_t* block = NULL;
+//! 32 byte units in the pool, one bit each in the bitmap
+#define MEM_UNITS (OS_MEM_POOL_SIZE / MEMORY_BLOCK_32)
+
+//! bitmap words
+#define MEM_WORDS ((MEM_UNITS + 31) / 32)
+
+//! key fields
+#define MEM_KEY_INDEX(key)      ((key) & 0x3FU)
+#define MEM_KEY_CLASS(key)      (((key) >> 6) & 0x3U)
+#define MEM_KEY_GENERATION(key) ((uint8_t)((key) >> 8))
+
+static uint8_t pool[OS_MEM_POOL_SIZE] __attribute__((aligned(4))) = {0};
+
+//! allocated units, updated with compare and swap only
+static uint32_t used[MEM_WORDS] = {0};
+
+//! per unit allocation count 0-254, key generations are one more so 0 is never a valid key.
+//! Wraps, a key comes back after 255 frees of its block
+static uint8_t generation[MEM_UNITS] = {0};
 
-    // create mask
-    uint8_t  block_bits = (size / MEMORY_BLOCK_32);
-    uint32_t search_mask = (1U << block_bits) - 1;
+static int8_t   SizeClass(BlockSize_t size);
+static uint16_t MakeKey(uint8_t index, uint8_t size_class);
+static bool     KeyIsCurrent(uint16_t key, uint32_t* mask, uint8_t* word);
 
-    // make sure we're not going to loop forever
-    if (0 >= POOL_SIZE / 32 - size)
+/**
+ * @brief Size class of a block size, units per block are 1 << class
+ *
+ * @param size
+ * @return int8_t -1 if size isn't a MEMORY_BLOCK_* size
+ */
+static int8_t SizeClass(BlockSize_t size)
+{
+    switch (size)
     {
-        *status = OS_ERROR;
-        return NULL;
+        case MEMORY_BLOCK_32:
+            return 0;
+        case MEMORY_BLOCK_64:
+            return 1;
+        case MEMORY_BLOCK_128:
+            return 2;
+        case MEMORY_BLOCK_256:
+            return 3;
+        default:
+            return -1;
     }
+}
+
+/**
+ * @brief Key of a block just allocated, generation in the high byte
+ *
+ * @param index first unit of the block
+ * @param size_class
+ * @return uint16_t
+ */
+static uint16_t MakeKey(uint8_t index, uint8_t size_class)
+{
+    uint8_t count = __atomic_load_n(&generation[index], __ATOMIC_ACQUIRE);
 
-    // don't want to be interrupted while getting this memory,
-    // multiple objects could get keys to the same memory
-    DISABLE_INTERRUPTS();
+    return (uint16_t)(((count + 1U) << 8) | ((uint16_t)size_class << 6) | index);
+}
 
-    // iterate and shift on multiple of of block size (i.e. the number of bits in "used")
-    for (uint8_t i = 0; i < (POOL_SIZE / 32) - block_bits; i += block_bits)
+/**
+ * @brief Checks the key against the block's allocation, catches stale and made up keys
+ *
+ * @param key
+ * @param mask bits of the block in its bitmap word
+ * @param word bitmap word of the block
+ * @return true if the key belongs to the current allocation of the block
+ */
+static bool KeyIsCurrent(uint16_t key, uint32_t* mask, uint8_t* word)
+{
+    uint8_t index = MEM_KEY_INDEX(key);
+    uint8_t units = (uint8_t)(1U << MEM_KEY_CLASS(key));
+
+    // blocks are aligned to their size, so never cross a bitmap word
+    if (index + units > MEM_UNITS || 0 != (index & (units - 1U)))
     {
-        // if an empty location is found, use it
-        if (0 == (search_mask & used))
-        {
-            block = pool + (i * MEMORY_BLOCK_32);
-            used |= search_mask;
-            *key = (size << 8) | i;
+        return false;
+    }
 
-            break;
-        }
+    *word = index / 32U;
+    *mask = ((1U << units) - 1U) << (index % 32U);
 
-        search_mask <<= block_bits;
-    }
+    uint8_t count = __atomic_load_n(&generation[index], __ATOMIC_ACQUIRE);
+
+    return MEM_KEY_GENERATION(key) == (uint8_t)(count + 1U) &&
+           *mask == (__atomic_load_n(&used[*word], __ATOMIC_ACQUIRE) & *mask);
+}
+
+extern uint8_t* OSMemoryBlockNew(uint16_t* key, BlockSize_t size, OSStatus_t* status)
+{
+    int8_t size_class = SizeClass(size);
 
-    ENABLE_INTERRUPTS();
+    *key = OS_MEM_KEY_NONE;
 
-    // set status
-    if (NULL == block)
+    if (size_class < 0 || size > OS_MEM_POOL_SIZE)
     {
-        *status = OS_MEMORY_BLOCK_FULL;
+        *status = OS_INVALID_ARGUMENT;
+        return NULL;
     }
-    else
+
+    uint8_t  units = (uint8_t)(1U << size_class);
+    uint32_t block_mask = (1U << units) - 1U;
+
+    // no lock, a failed swap means another context took bits of this word, look again
+    for (uint8_t word = 0; word < MEM_WORDS; word++)
     {
-        *status = OS_SUCCESS;
+        uint32_t current = __atomic_load_n(&used[word], __ATOMIC_RELAXED);
+
+        for (uint8_t bit = 0; bit < 32U && word * 32U + bit + units <= MEM_UNITS; bit += units)
+        {
+            uint32_t mask = block_mask << bit;
+
+            while (0 == (current & mask))
+            {
+                if (__atomic_compare_exchange_n(&used[word], &current, current | mask, true,
+                                                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                {
+                    uint8_t index = (uint8_t)(word * 32U + bit);
+
+                    *key = MakeKey(index, (uint8_t)size_class);
+                    *status = OS_SUCCESS;
+
+                    return pool + index * MEMORY_BLOCK_32;
+                }
+            }
+        }
     }
 
-    // return pointer to block
-    return block;
+    *status = OS_MEMORY_BLOCK_FULL;
+
+    return NULL;
 }
 
 extern uint8_t* OSMemoryBlockGet(uint16_t key)
 {
-    // return the index of the block
-    return pool + MEMORY_BLOCK_32 * (key & 0xff);
+    uint32_t mask;
+    uint8_t  word;
+
+    if (!KeyIsCurrent(key, &mask, &word))
+    {
+        return NULL;
+    }
+
+    return pool + MEMORY_BLOCK_32 * MEM_KEY_INDEX(key);
 }
 
 extern OSStatus_t OSMemoryFreeBlock(uint16_t key)
 {
-    // build the mask
-    uint8_t  block_bits = ((key >> 8) / MEMORY_BLOCK_32);
-    uint32_t clear_mask = ~(((1 << block_bits) - 1) << (key & 0xff));
+    uint32_t mask;
+    uint8_t  word;
+    uint8_t  index = MEM_KEY_INDEX(key);
+
+    if (!KeyIsCurrent(key, &mask, &word))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    // retire the key first, of two frees racing with the same key only one gets past this
+    uint8_t count = (uint8_t)(MEM_KEY_GENERATION(key) - 1U);
+    uint8_t next = (uint8_t)((count + 1U) % 255U);
+
+    if (!__atomic_compare_exchange_n(&generation[index], &count, next, false, __ATOMIC_RELEASE,
+                                     __ATOMIC_RELAXED))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
 
-    // don't want to be interrupted here either
-    DISABLE_INTERRUPTS();
-    used &= clear_mask;
-    ENABLE_INTERRUPTS();
+    __atomic_fetch_and(&used[word], ~mask, __ATOMIC_RELEASE);
 
     return OS_SUCCESS;
 }
+#endif // OS_CFG_MEM
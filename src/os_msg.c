@@ -4,14 +4,41 @@
 
 #include "inc/os_msg.h"
 #include "inc/os.h"
+#include "inc/os_proxy.h"
+
+#ifdef OS_RECORD_ENABLED
+    #include "inc/os_record.h"
+#endif
 
 static void AdvancePointer(MessageQueue_t* q);
 static void RetreatPointer(MessageQueue_t* q);
+static bool CoalesceMessage(MessageQueue_t* q, Message_t* msg);
+static bool AppendMessage(MessageQueue_t* q, Message_t* msg);
+static bool PackedAppendMessage(MessageQueue_t* q, Message_t* msg);
+static bool PackedDropOldest(MessageQueue_t* q);
+static uint16_t PackedFindMessage(MessageQueue_t* q, uint16_t offset);
+static uint16_t RingCount(MessageQueue_t* q);
+static bool OverflowAppendMessage(MessageQueue_t* q, Message_t* msg);
+static MessageQueueStatus_t QueuePut(ActiveObject_t* dest, void* msg);
+
+//! shared overflow pool
+static MessageOverflowPool_t overflow_pool = {NULL, 0, MSG_OVERFLOW_NONE, 0, 0, 0};
+
+//! bytes taken by a message in a packed queue
+#define PACKED_STRIDE(msg_size) ((uint16_t)(((msg_size) + 3U) & ~3U))
+
+//! message in a packed queue
+#define PACKED_MESSAGE_AT(q, offset) ((Message_t*)((uint8_t*)(q)->queue + (offset)))
 
 bool MsgQueueIsEmpty(MessageQueue_t* q)
 {
-    // not full and head and tail are the same
-    return !q->is_full && (q->head == q->tail);
+    if (q->is_packed)
+    {
+        return 0 == q->count;
+    }
+
+    // not full and head and tail are the same, nothing borrowed
+    return !q->is_full && (q->head == q->tail) && 0 == q->overflow_count;
 }
 
 /**
@@ -71,20 +98,422 @@ void MsgQueueCreate(MessageQueue_t* q, const uint16_t size, MessageGeneric_t* qu
     q->head = 0;
     q->tail = 0;
     q->is_full = false;
+    q->policy = MSG_Q_POLICY_REJECT;
+    q->high_watermark = 0;
+    q->on_HighWatermark = NULL;
+    q->dropped = 0;
+    q->coalesced = 0;
+
+    q->is_packed = false;
+    q->used = 0;
+    q->held = 0;
+    q->count = 0;
+
+    q->borrow_cap = 0;
+    q->borrowed = 0;
+    q->peak_borrowed = 0;
+    q->overflow_count = 0;
+    q->overflow_head = MSG_OVERFLOW_NONE;
+    q->overflow_tail = MSG_OVERFLOW_NONE;
+    q->overflow_held = MSG_OVERFLOW_NONE;
+}
+
+void MsgQueueCreatePacked(MessageQueue_t* q, const uint16_t size_bytes, void* buffer)
+{
+    MsgQueueCreate(q, size_bytes & ~3U, (MessageGeneric_t*)buffer);
+    q->is_packed = true;
+}
+
+/**
+ * @brief Number of messages in the queue's own buffer
+ *
+ * @param q
+ * @return uint16_t
+ */
+static uint16_t RingCount(MessageQueue_t* q)
+{
+    if (q->is_full)
+    {
+        return q->size;
+    }
+
+    return (q->head >= q->tail) ? (q->head - q->tail) : (q->size - q->tail + q->head);
+}
+
+uint16_t MsgQueueCount(MessageQueue_t* q)
+{
+    if (q->is_packed)
+    {
+        return q->count;
+    }
+
+    return RingCount(q) + q->overflow_count;
+}
+
+void MsgOverflowPoolInit(MessageOverflowSlot_t* slots, uint16_t size)
+{
+    // chain all slots into the free list
+    for (uint16_t i = 0; i < size; i++)
+    {
+        slots[i].next = (i + 1 < size) ? i + 1 : MSG_OVERFLOW_NONE;
+    }
+
+    overflow_pool.slots = slots;
+    overflow_pool.size = size;
+    overflow_pool.free_head = size ? 0 : MSG_OVERFLOW_NONE;
+    overflow_pool.in_use = 0;
+    overflow_pool.peak_in_use = 0;
+    overflow_pool.exhausted = 0;
+}
+
+const MessageOverflowPool_t* MsgOverflowPoolGet()
+{
+    return &overflow_pool;
+}
+
+void MsgQueueSetOverflow(MessageQueue_t* q, uint16_t borrow_cap)
+{
+    q->borrow_cap = q->is_packed ? 0 : borrow_cap;
+}
+
+void MsgQueueSetPolicy(MessageQueue_t* q, MessageQueuePolicy_t policy)
+{
+    q->policy = policy;
+}
+
+void MsgQueueSetHighWatermark(MessageQueue_t* q, uint16_t level, MessageQueueWatermark_f callback)
+{
+    q->high_watermark = level;
+    q->on_HighWatermark = callback;
+}
+
+/**
+ * @brief Overwrites a queued message with the same id, call with interrupts disabled
+ *
+ * @param q
+ * @param msg
+ * @return true if a message was replaced
+ */
+static bool CoalesceMessage(MessageQueue_t* q, Message_t* msg)
+{
+    uint16_t index = q->tail;
+
+    // oldest to newest, own buffer first
+    for (uint16_t n = q->is_packed ? q->count : RingCount(q); n > 0; n--)
+    {
+        Message_t* queued;
+
+        if (q->is_packed)
+        {
+            index = PackedFindMessage(q, index);
+            queued = PACKED_MESSAGE_AT(q, index);
+        }
+        else
+        {
+            queued = (Message_t*)&q->queue[index];
+        }
+
+        // packed messages can only be replaced by one taking the same space
+        if (queued->id == msg->id &&
+            (!q->is_packed || PACKED_STRIDE(queued->msg_size) == PACKED_STRIDE(msg->msg_size)))
+        {
+            MsgCopy(queued, msg);
+            return true;
+        }
+
+        index += q->is_packed ? PACKED_STRIDE(queued->msg_size) : 1;
+
+        if (q->size == index)
+        {
+            index = 0;
+        }
+    }
+
+    for (index = q->overflow_head; MSG_OVERFLOW_NONE != index;
+         index = overflow_pool.slots[index].next)
+    {
+        Message_t* queued = (Message_t*)&overflow_pool.slots[index].msg;
+
+        if (queued->id == msg->id)
+        {
+            MsgCopy(queued, msg);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Copies the message into a slot borrowed from the overflow pool,
+ *        call with interrupts disabled
+ *
+ * @param q
+ * @param msg
+ * @return true if added
+ */
+static bool OverflowAppendMessage(MessageQueue_t* q, Message_t* msg)
+{
+    if (q->borrowed >= q->borrow_cap)
+    {
+        return false;
+    }
+
+    uint16_t slot = overflow_pool.free_head;
+
+    if (MSG_OVERFLOW_NONE == slot)
+    {
+        overflow_pool.exhausted++;
+        return false;
+    }
+
+    overflow_pool.free_head = overflow_pool.slots[slot].next;
+    overflow_pool.slots[slot].next = MSG_OVERFLOW_NONE;
+
+    MsgCopy(&overflow_pool.slots[slot].msg, msg);
+
+    // append to the queue's overflow list
+    if (MSG_OVERFLOW_NONE == q->overflow_tail)
+    {
+        q->overflow_head = slot;
+    }
+    else
+    {
+        overflow_pool.slots[q->overflow_tail].next = slot;
+    }
+
+    q->overflow_tail = slot;
+    q->overflow_count++;
+
+    // statistics
+    if (++q->borrowed > q->peak_borrowed)
+    {
+        q->peak_borrowed = q->borrowed;
+    }
+
+    if (++overflow_pool.in_use > overflow_pool.peak_in_use)
+    {
+        overflow_pool.peak_in_use = overflow_pool.in_use;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Copies the message into the next slot, call with interrupts disabled
+ *
+ * @param q
+ * @param msg
+ * @return true if added
+ */
+static bool AppendMessage(MessageQueue_t* q, Message_t* msg)
+{
+    // once borrowing, keep borrowing until drained so messages stay in order
+    if ((q->is_full || 0 != q->overflow_count) && OverflowAppendMessage(q, msg))
+    {
+        return true;
+    }
+
+    // dropping from the own buffer would reorder borrowed messages
+    if (0 != q->overflow_count)
+    {
+        return false;
+    }
+
+    if (q->is_full)
+    {
+        if (MSG_Q_POLICY_DROP_OLDEST != q->policy)
+        {
+            return false;
+        }
+
+        // head is on the oldest message, AdvancePointer moves the tail past it
+        q->dropped++;
+    }
+
+    // copy message into buffer
+    MsgCopy(&q->queue[q->head], msg);
+    AdvancePointer(q);
+
+    return true;
+}
+
+/**
+ * @brief Where the message at offset really starts, skipping the unused end of the buffer
+ *
+ * The writer wraps when a message doesn't fit before the end. The skipped bytes are
+ * either too few to hold a Message_t or start with a msg_size 0 marker.
+ *
+ * @param q
+ * @param offset
+ * @return uint16_t
+ */
+static uint16_t PackedFindMessage(MessageQueue_t* q, uint16_t offset)
+{
+    if ((uint16_t)(q->size - offset) < sizeof(Message_t) ||
+        0 == PACKED_MESSAGE_AT(q, offset)->msg_size)
+    {
+        return 0;
+    }
+
+    return offset;
+}
+
+/**
+ * @brief Frees the oldest unread message, call with interrupts disabled
+ *
+ * @param q
+ * @return true if space was freed
+ */
+static bool PackedDropOldest(MessageQueue_t* q)
+{
+    // a held message is older and blocks the space
+    if (0 == q->count || 0 != q->held)
+    {
+        return false;
+    }
+
+    uint16_t offset = PackedFindMessage(q, q->tail);
+    uint16_t skipped = (offset != q->tail) ? q->size - q->tail : 0;
+    uint16_t stride = PACKED_STRIDE(PACKED_MESSAGE_AT(q, offset)->msg_size);
+
+    q->tail = (q->size == offset + stride) ? 0 : offset + stride;
+    q->used -= skipped + stride;
+    q->count--;
+    q->dropped++;
+
+    return true;
+}
+
+/**
+ * @brief Copies the message into the byte ring, call with interrupts disabled
+ *
+ * @param q
+ * @param msg
+ * @return true if added
+ */
+static bool PackedAppendMessage(MessageQueue_t* q, Message_t* msg)
+{
+    uint16_t stride = PACKED_STRIDE(msg->msg_size);
+
+    while (true)
+    {
+        // empty, start over at the front so the whole buffer is free in one piece
+        if (0 == q->used)
+        {
+            q->head = 0;
+            q->tail = 0;
+        }
+
+        uint16_t free_bytes = q->size - q->used;
+        uint16_t end_bytes = q->size - q->head;
+
+        // fits before the end, or after skipping the end
+        if ((end_bytes >= stride && free_bytes >= stride) ||
+            (end_bytes < stride && free_bytes >= end_bytes + stride))
+        {
+            break;
+        }
+
+        if (MSG_Q_POLICY_DROP_OLDEST != q->policy || !PackedDropOldest(q))
+        {
+            return false;
+        }
+    }
+
+    if (q->size - q->head < stride)
+    {
+        // too short to hold a marker, reader wraps by itself
+        if ((uint16_t)(q->size - q->head) >= sizeof(Message_t))
+        {
+            PACKED_MESSAGE_AT(q, q->head)->msg_size = 0;
+        }
+
+        q->used += q->size - q->head;
+        q->head = 0;
+    }
+
+    MsgCopy(PACKED_MESSAGE_AT(q, q->head), msg);
+
+    q->head = (q->size == q->head + stride) ? 0 : q->head + stride;
+    q->used += stride;
+    q->count++;
+
+    return true;
 }
 
 MessageQueueStatus_t MsgQueuePut(ActiveObject_t* dest, void* msg)
 {
+    MessageQueueStatus_t status = QueuePut(dest, msg);
+
+#ifdef OS_RECORD_ENABLED
+    // after the put, a replay mustn't deliver what the queue rejected
+    OSRecordMessage(OS_RECORD_PUT, dest, (Message_t*)msg, status);
+#endif
+
+    return status;
+}
+
+MessageQueueStatus_t MsgQueuePutTimed(ActiveObject_t* dest, void* msg)
+{
+    MessageQueueStatus_t status = QueuePut(dest, msg);
+
+#ifdef OS_RECORD_ENABLED
+    OSRecordMessage(OS_RECORD_TIMED, dest, (Message_t*)msg, status);
+#endif
+
+    return status;
+}
+
+/**
+ * @brief Appends the message or applies the queue policy, readies the AO
+ *
+ * @param dest
+ * @param msg
+ * @return MessageQueueStatus_t
+ */
+static MessageQueueStatus_t QueuePut(ActiveObject_t* dest, void* msg)
+{
+    MessageQueue_t* q = dest->msg_queue;
+    uint16_t        count = 0;
+
+#if OS_CFG_PROXY
+    // remote AO, goes into the link's next frame
+    if (dest->proxy)
+    {
+        return ProxySend(dest, (Message_t*)msg);
+    }
+#endif
+
+#if OS_CFG_DIRECT
+    // receiver can run right away on this stack, skip the queue
+    if (dest->direct && SchedulerDispatchDirect(dest, (Message_t*)msg))
+    {
+        return MSG_Q_SUCCESS;
+    }
+#endif
+
+    // can't be stored in this queue at all, not a full queue
+    if (q->is_packed && (((Message_t*)msg)->msg_size < sizeof(Message_t) ||
+                         PACKED_STRIDE(((Message_t*)msg)->msg_size) > q->size))
+    {
+        return MSG_Q_ERROR;
+    }
+
     // critical section
     DISABLE_INTERRUPTS();
     MessageQueueStatus_t status = MSG_Q_SUCCESS;
+    uint16_t             before = MsgQueueCount(q);
 
-    // add only if full
-    if (!dest->msg_queue->is_full)
+    if (MSG_Q_POLICY_COALESCE == q->policy && CoalesceMessage(q, (Message_t*)msg))
     {
-        // copy message into buffer
-        os_memcpy(&dest->msg_queue->queue[dest->msg_queue->head], msg, ((Message_t*)msg)->msg_size);
-        AdvancePointer(dest->msg_queue);
+        // latest value replaced the queued one, AO is already ready
+        q->coalesced++;
+    }
+    else if (q->is_packed ? PackedAppendMessage(q, (Message_t*)msg)
+                          : AppendMessage(q, (Message_t*)msg))
+    {
+        count = MsgQueueCount(q);
 
 #ifdef OS_TRACE_ENABLED
         OSGetOS()->on_DebugPrint(dest->id, ((Message_t*)msg)->id, DEBUG_PRINT_IS_QUEUE);
@@ -95,29 +524,110 @@ MessageQueueStatus_t MsgQueuePut(ActiveObject_t* dest, void* msg)
     }
     else
     {
+        q->dropped++;
         status = MSG_Q_FULL;
     }
 
     ENABLE_INTERRUPTS();
 
+    // outside of the critical section, producer can throttle. Only when the count rises to the
+    // watermark, drop-oldest keeps a full queue at it on every put
+    if (q->on_HighWatermark && count == q->high_watermark && before < count)
+    {
+        q->on_HighWatermark(dest, count);
+    }
+
     return status;
 }
 
 void* MsgQueueGet(ActiveObject_t* ao)
 {
-    void* data;
+    MessageQueue_t* q = ao->msg_queue;
+    void*           data;
 
-    while (MsgQueueIsEmpty(ao->msg_queue))
+    while (MsgQueueIsEmpty(q))
     {
         // block, should not block because MsgQueueGet wshould not be called unless message is in
         // queue
     }
 
-    // get first message in queue
-    data = (void*)&ao->msg_queue->queue[ao->msg_queue->tail];
+    if (q->is_packed)
+    {
+        // producers look at tail, used and count
+        DISABLE_INTERRUPTS();
+
+        uint16_t offset = PackedFindMessage(q, q->tail);
+        uint16_t skipped = (offset != q->tail) ? q->size - q->tail : 0;
+        uint16_t stride = PACKED_STRIDE(PACKED_MESSAGE_AT(q, offset)->msg_size);
 
-    // move up read index
-    RetreatPointer(ao->msg_queue);
+        data = PACKED_MESSAGE_AT(q, offset);
 
-    return data;
+        // space stays used until MsgQueueRelease
+        q->tail = (q->size == offset + stride) ? 0 : offset + stride;
+        q->held += skipped + stride;
+        q->count--;
+
+        ENABLE_INTERRUPTS();
+
+        return data;
+    }
+
+    // drop-oldest producers move tail as well
+    DISABLE_INTERRUPTS();
+
+    if (q->is_full || q->head != q->tail)
+    {
+        // get first message in queue
+        data = (void*)&q->queue[q->tail];
+
+        // move up read index
+        RetreatPointer(q);
+
+        ENABLE_INTERRUPTS();
+
+        return data;
+    }
+
+    // own buffer drained, continue with borrowed slots
+    uint16_t slot = q->overflow_head;
+
+    q->overflow_head = overflow_pool.slots[slot].next;
+    q->overflow_count--;
+
+    if (MSG_OVERFLOW_NONE == q->overflow_head)
+    {
+        q->overflow_tail = MSG_OVERFLOW_NONE;
+    }
+
+    // slot goes back to the pool in MsgQueueRelease
+    q->overflow_held = slot;
+
+    ENABLE_INTERRUPTS();
+
+    return &overflow_pool.slots[slot].msg;
+}
+
+void MsgQueueRelease(MessageQueue_t* q)
+{
+    if (q->is_packed)
+    {
+        DISABLE_INTERRUPTS();
+        q->used -= q->held;
+        q->held = 0;
+        ENABLE_INTERRUPTS();
+    }
+    else if (MSG_OVERFLOW_NONE != q->overflow_held)
+    {
+        DISABLE_INTERRUPTS();
+
+        // give the slot back
+        overflow_pool.slots[q->overflow_held].next = overflow_pool.free_head;
+        overflow_pool.free_head = q->overflow_held;
+        overflow_pool.in_use--;
+
+        q->borrowed--;
+        q->overflow_held = MSG_OVERFLOW_NONE;
+
+        ENABLE_INTERRUPTS();
+    }
 }
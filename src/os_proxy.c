@@ -0,0 +1,330 @@
+/**
+ * @file os_proxy.c
+ */
+
+#include "inc/os_proxy.h"
+#include "inc/os_defer.h"
+
+#if OS_CFG_PROXY
+
+//! every initialized link, see ProxyRetryFlushes
+static ProxyLink_t* links = NULL;
+
+static uint16_t Crc16(uint16_t crc, const uint8_t* data, uint32_t len);
+static void     ScheduleFlush(ProxyLink_t* link);
+static void     ReceiveFrame(ProxyReceiver_t* rx);
+
+//! receiver parser states
+#define PROXY_RX_SYNC     0
+#define PROXY_RX_LENGTH_L 1
+#define PROXY_RX_LENGTH_H 2
+#define PROXY_RX_PAYLOAD  3
+#define PROXY_RX_CRC_L    4
+#define PROXY_RX_CRC_H    5
+
+/**
+ * @brief CRC-16/CCITT-FALSE, bitwise
+ *
+ * @param crc 0xFFFF to start
+ * @param data
+ * @param len
+ * @return uint16_t
+ */
+static uint16_t Crc16(uint16_t crc, const uint8_t* data, uint32_t len)
+{
+    while (len--)
+    {
+        crc ^= (uint16_t)(*data++ << 8U);
+
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1U) ^ 0x1021U) : (uint16_t)(crc << 1U);
+        }
+    }
+
+    return crc;
+}
+
+extern void ProxyLinkInit(ProxyLink_t* link, ProxyTransport_f transport, void* context,
+                          uint8_t* buffer, uint16_t size, uint8_t flush_priority)
+{
+    link->transport = transport;
+    link->context = context;
+    link->buffers[0] = buffer;
+    link->buffers[1] = buffer + size;
+    link->size = size;
+    link->used = PROXY_FRAME_HEADER;
+    link->active = 0;
+    link->flush_priority = flush_priority;
+    link->flush_pending = false;
+    link->sending = false;
+    link->frames = 0;
+    link->messages = 0;
+    link->dropped = 0;
+
+    for (ProxyLink_t* other = links; other; other = other->next)
+    {
+        if (other == link)
+        {
+            return;
+        }
+    }
+
+    link->next = links;
+    links = link;
+}
+
+extern void ProxyCreate(ActiveObject_t* proxy, ProxyLink_t* link, uint8_t remote_id)
+{
+    // never readied, has no queue
+    ActiveObjectCreate(proxy, 0xFE, NULL, NULL, remote_id);
+    proxy->proxy = link;
+}
+
+/**
+ * @brief Queues the flush of the frame being filled, unless it's queued already or the
+ *        transport is busy, then the end of that send schedules it
+ *
+ * @param link
+ */
+static void ScheduleFlush(ProxyLink_t* link)
+{
+    bool flush = false;
+
+    DISABLE_INTERRUPTS();
+
+    if (!link->flush_pending && !link->sending && PROXY_FRAME_HEADER != link->used)
+    {
+        link->flush_pending = true;
+        flush = true;
+    }
+
+    ENABLE_INTERRUPTS();
+
+    if (flush && OS_SUCCESS != DeferCall(ProxyFlush, link, link->flush_priority))
+    {
+        // defer pool full, the next message or ProxyRetryFlushes tries again
+        link->flush_pending = false;
+    }
+}
+
+extern MessageQueueStatus_t ProxySend(ActiveObject_t* proxy, Message_t* msg)
+{
+    ProxyLink_t* link = proxy->proxy;
+
+    DISABLE_INTERRUPTS();
+
+    // room for the id byte, the message and the CRC
+    if (link->used + 1U + msg->msg_size + 2U > link->size)
+    {
+        link->dropped++;
+        ENABLE_INTERRUPTS();
+        return MSG_Q_FULL;
+    }
+
+    uint8_t* record = &link->buffers[link->active][link->used];
+
+    record[0] = proxy->id;
+    os_memcpy(&record[1], msg, msg->msg_size);
+
+    link->used += 1U + msg->msg_size;
+    link->messages++;
+
+    ENABLE_INTERRUPTS();
+
+    ScheduleFlush(link);
+
+    return MSG_Q_SUCCESS;
+}
+
+extern void ProxyFlush(void* arg)
+{
+    ProxyLink_t* link = (ProxyLink_t*)arg;
+
+    // new messages go to the other buffer while this frame is sent
+    DISABLE_INTERRUPTS();
+
+    uint8_t* frame = link->buffers[link->active];
+    uint16_t used = link->used;
+
+    link->flush_pending = false;
+
+    // the other buffer is still being sent, ProxyLinkSendComplete flushes this one
+    if (link->sending || PROXY_FRAME_HEADER == used)
+    {
+        ENABLE_INTERRUPTS();
+        return;
+    }
+
+    link->sending = true;
+    link->active ^= 1U;
+    link->used = PROXY_FRAME_HEADER;
+
+    ENABLE_INTERRUPTS();
+
+    uint16_t length = used - PROXY_FRAME_HEADER;
+
+    frame[0] = PROXY_FRAME_SYNC;
+    frame[1] = (uint8_t)(length & 0xFFU);
+    frame[2] = (uint8_t)(length >> 8U);
+
+    uint16_t crc = Crc16(0xFFFFU, &frame[1], used - 1U);
+
+    frame[used] = (uint8_t)(crc & 0xFFU);
+    frame[used + 1U] = (uint8_t)(crc >> 8U);
+
+    ProxyTransportStatus_t status = link->transport(link->context, frame, used + 2U);
+
+    if (PROXY_TRANSPORT_ERROR == status)
+    {
+        link->dropped++;
+    }
+    else
+    {
+        link->frames++;
+    }
+
+    if (PROXY_TRANSPORT_BUSY != status)
+    {
+        ProxyLinkSendComplete(link);
+    }
+}
+
+extern void ProxyLinkSendComplete(ProxyLink_t* link)
+{
+    DISABLE_INTERRUPTS();
+    link->sending = false;
+    ENABLE_INTERRUPTS();
+
+    // messages posted while the frame was sent
+    ScheduleFlush(link);
+}
+
+extern void ProxyRetryFlushes()
+{
+    for (ProxyLink_t* link = links; link; link = link->next)
+    {
+        ScheduleFlush(link);
+    }
+}
+
+extern void ProxyReceiverInit(ProxyReceiver_t* rx, ActiveObject_t* const* aos, uint16_t ao_count,
+                              uint8_t* buffer, uint16_t size)
+{
+    rx->aos = aos;
+    rx->ao_count = ao_count;
+    rx->buffer = buffer;
+    rx->size = size;
+    rx->state = PROXY_RX_SYNC;
+    rx->length = 0;
+    rx->received = 0;
+    rx->crc = 0;
+    rx->frames = 0;
+    rx->crc_errors = 0;
+    rx->dropped = 0;
+}
+
+/**
+ * @brief Checks the CRC and posts the frame's messages
+ *
+ * @param rx
+ */
+static void ReceiveFrame(ProxyReceiver_t* rx)
+{
+    uint8_t  length[2] = {(uint8_t)(rx->length & 0xFFU), (uint8_t)(rx->length >> 8U)};
+    uint16_t crc = Crc16(Crc16(0xFFFFU, length, 2), rx->buffer, rx->length);
+
+    if (crc != rx->crc)
+    {
+        rx->crc_errors++;
+        return;
+    }
+
+    rx->frames++;
+
+    for (uint16_t offset = 0; offset + 1U + sizeof(Message_t) <= rx->length;)
+    {
+        uint8_t  id = rx->buffer[offset];
+        uint32_t msg[(255 + 3) / 4];
+
+        // payload is unaligned, the size byte is the same for every message layout
+        uint8_t size = rx->buffer[offset + 1U + offsetof(Message_t, msg_size)];
+
+        // the rest of the frame can't be split into records
+        if (size < sizeof(Message_t) || offset + 1U + size > rx->length)
+        {
+            rx->crc_errors++;
+            return;
+        }
+
+        os_memcpy(msg, &rx->buffer[offset + 1U], size);
+        offset += 1U + size;
+
+        ActiveObject_t* ao = (id < rx->ao_count) ? rx->aos[id] : NULL;
+
+        // larger than a slot, only a packed queue or another link can take it
+        if (!ao ||
+            (size > OS_MESSAGE_MAX_SIZE && !AO_IS_PROXY(ao) && !ao->msg_queue->is_packed) ||
+            MSG_Q_SUCCESS != MsgQueuePut(ao, msg))
+        {
+            rx->dropped++;
+        }
+    }
+}
+
+extern void ProxyReceive(ProxyReceiver_t* rx, const uint8_t* data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        uint8_t byte = data[i];
+
+        switch (rx->state)
+        {
+            case PROXY_RX_SYNC:
+                rx->state = (PROXY_FRAME_SYNC == byte) ? PROXY_RX_LENGTH_L : PROXY_RX_SYNC;
+                break;
+
+            case PROXY_RX_LENGTH_L:
+                rx->length = byte;
+                rx->state = PROXY_RX_LENGTH_H;
+                break;
+
+            case PROXY_RX_LENGTH_H:
+                rx->length |= (uint16_t)(byte << 8U);
+                rx->received = 0;
+
+                // too large for us, can't be a frame
+                if (rx->length > rx->size)
+                {
+                    rx->crc_errors++;
+                    rx->state = PROXY_RX_SYNC;
+                }
+                else
+                {
+                    rx->state = rx->length ? PROXY_RX_PAYLOAD : PROXY_RX_CRC_L;
+                }
+                break;
+
+            case PROXY_RX_PAYLOAD:
+                rx->buffer[rx->received++] = byte;
+
+                if (rx->received == rx->length)
+                {
+                    rx->state = PROXY_RX_CRC_L;
+                }
+                break;
+
+            case PROXY_RX_CRC_L:
+                rx->crc = byte;
+                rx->state = PROXY_RX_CRC_H;
+                break;
+
+            default:
+                rx->crc |= (uint16_t)(byte << 8U);
+                rx->state = PROXY_RX_SYNC;
+                ReceiveFrame(rx);
+                break;
+        }
+    }
+}
+#endif // OS_CFG_PROXY
@@ -0,0 +1,237 @@
+/**
+ * @file os_record.c
+ */
+
+#include "inc/os_record.h"
+#include "inc/os_port.h"
+
+#if OS_CFG_RECORD
+
+static void RecordWrite(Stream_t* stream, const void* data, uint32_t len);
+static bool ReplayPeek(OSReplay_t* replay, OSRecordHeader_t* header);
+static bool ReplayInject(OSReplay_t* replay);
+
+//! stream receiving records, NULL when not recording
+static Stream_t* record_stream = NULL;
+
+//! time of the last record
+static uint64_t record_last_us = 0;
+
+//! records that didn't fit
+static uint32_t record_dropped = 0;
+
+extern void OSRecordStart(Stream_t* stream)
+{
+    record_dropped = 0;
+    record_last_us = OSGetTimeUs();
+    record_stream = stream;
+}
+
+extern void OSRecordStop()
+{
+    record_stream = NULL;
+}
+
+extern uint32_t OSRecordDropped()
+{
+    return record_dropped;
+}
+
+/**
+ * @brief Copies into the stream without notifying, call from a critical section
+ *
+ * @param stream
+ * @param data
+ * @param len
+ */
+static void RecordWrite(Stream_t* stream, const void* data, uint32_t len)
+{
+    const uint8_t* src = (const uint8_t*)data;
+
+    while (len)
+    {
+        uint8_t* window;
+        uint32_t count = StreamWriteAcquire(stream, &window);
+
+        if (count > len)
+        {
+            count = len;
+        }
+
+        os_memcpy(window, src, count);
+        __atomic_store_n(&stream->head, stream->head + count, __ATOMIC_RELEASE);
+
+        src += count;
+        len -= count;
+    }
+}
+
+extern void OSRecordMessage(uint8_t kind, ActiveObject_t* dest, Message_t* msg,
+                            MessageQueueStatus_t status)
+{
+    Stream_t* stream = record_stream;
+
+    if (!stream)
+    {
+        return;
+    }
+
+    ActiveObject_t*  current = SchedulerGetCurrentAO();
+    uint64_t         now = OSGetTimeUs();
+    OSRecordHeader_t header = {kind, OS_RECORD_SOURCE_IDLE, dest->id, msg->msg_size, status,
+                               {0, 0, 0}, 0};
+
+    if (OS_RECORD_TIMED == kind)
+    {
+        header.source = OS_RECORD_SOURCE_TIMER;
+    }
+    else if (OSPortInIsr())
+    {
+        header.source = OS_RECORD_SOURCE_ISR;
+    }
+    else if (current)
+    {
+        header.source = current->id;
+    }
+
+    // every producer context writes here, records must not interleave
+    DISABLE_INTERRUPTS();
+
+    if (StreamFree(stream) < sizeof(OSRecordHeader_t) + msg->msg_size)
+    {
+        record_dropped++;
+        ENABLE_INTERRUPTS();
+        return;
+    }
+
+    // time was read before an interrupting record, don't go back
+    if (now > record_last_us)
+    {
+        header.delta_us = (uint32_t)(now - record_last_us);
+        record_last_us = now;
+    }
+
+    RecordWrite(stream, &header, sizeof(OSRecordHeader_t));
+    RecordWrite(stream, msg, msg->msg_size);
+
+    ENABLE_INTERRUPTS();
+
+    // nothing written, notifies the consumer by its threshold
+    StreamWriteCommit(stream, 0);
+}
+
+extern void OSReplayInit(OSReplay_t* replay, const uint8_t* log, uint32_t length,
+                         ActiveObject_t* const* aos, uint16_t ao_count, bool inject_timed)
+{
+    replay->log = log;
+    replay->length = length;
+    replay->offset = 0;
+    replay->aos = aos;
+    replay->ao_count = ao_count;
+    replay->inject_timed = inject_timed;
+    replay->time_us = 0;
+    replay->injected = 0;
+    replay->skipped = 0;
+    replay->rejected = 0;
+}
+
+/**
+ * @brief Reads the next header without consuming it
+ *
+ * @param replay
+ * @param header
+ * @return false at the end of the log or on a truncated record
+ */
+static bool ReplayPeek(OSReplay_t* replay, OSRecordHeader_t* header)
+{
+    if (replay->offset + sizeof(OSRecordHeader_t) > replay->length)
+    {
+        return false;
+    }
+
+    // log may be unaligned
+    os_memcpy(header, &replay->log[replay->offset], sizeof(OSRecordHeader_t));
+
+    return replay->offset + sizeof(OSRecordHeader_t) + header->size <= replay->length;
+}
+
+/**
+ * @brief Consumes the next record and posts it if it came from outside the AOs
+ *
+ * @param replay
+ * @return true if posted
+ */
+static bool ReplayInject(OSReplay_t* replay)
+{
+    OSRecordHeader_t header;
+    uint32_t         msg[(255 + 3) / 4];
+
+    ReplayPeek(replay, &header);
+    os_memcpy(msg, &replay->log[replay->offset + sizeof(OSRecordHeader_t)], header.size);
+
+    replay->offset += sizeof(OSRecordHeader_t) + header.size;
+
+    // never delivered when recorded
+    if (MSG_Q_SUCCESS != header.status)
+    {
+        replay->rejected++;
+        return false;
+    }
+
+    bool external = OS_RECORD_SOURCE_TIMER <= header.source;
+
+    if (OS_RECORD_SOURCE_TIMER == header.source && !replay->inject_timed)
+    {
+        external = false;
+    }
+
+    if (!external || header.dest >= replay->ao_count || !replay->aos[header.dest])
+    {
+        replay->skipped++;
+        return false;
+    }
+
+    MsgQueuePut(replay->aos[header.dest], msg);
+    replay->injected++;
+
+    return true;
+}
+
+extern bool OSReplayNext(OSReplay_t* replay)
+{
+    OSRecordHeader_t header;
+
+    while (ReplayPeek(replay, &header))
+    {
+        replay->time_us += header.delta_us;
+
+        if (ReplayInject(replay))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+extern uint32_t OSReplayUntil(OSReplay_t* replay, uint64_t now_us)
+{
+    OSRecordHeader_t header;
+    uint32_t         injected = 0;
+
+    while (ReplayPeek(replay, &header) && replay->time_us + header.delta_us <= now_us)
+    {
+        replay->time_us += header.delta_us;
+        injected += ReplayInject(replay) ? 1 : 0;
+    }
+
+    return injected;
+}
+
+extern bool OSReplayDone(OSReplay_t* replay)
+{
+    OSRecordHeader_t header;
+
+    return !ReplayPeek(replay, &header);
+}
+#endif // OS_CFG_RECORD
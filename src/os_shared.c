@@ -0,0 +1,80 @@
+/**
+ * @file os_shared.c
+ */
+
+#include "inc/os_shared.h"
+
+#if OS_CFG_SHARED
+
+extern void SharedStateInit(SharedState_t* state, void* value, uint16_t size)
+{
+    state->sequence = 0;
+    state->value = value;
+    state->size = size;
+    state->subscriber_count = 0;
+}
+
+extern OSStatus_t SharedStateSubscribe(SharedState_t* state, ActiveObject_t* ao, uint32_t flags)
+{
+    if (SHARED_STATE_MAX_SUBSCRIBERS == state->subscriber_count || AO_IS_PROXY(ao))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    state->subscribers[state->subscriber_count] = ao;
+    state->flags[state->subscriber_count] = flags;
+    state->subscriber_count++;
+
+    return OS_SUCCESS;
+}
+
+extern void SharedStatePublish(SharedState_t* state, const void* value)
+{
+    uint32_t sequence = state->sequence;
+
+    // odd, readers retry from here on, the value must not be written before
+    __atomic_store_n(&state->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    os_memcpy(state->value, value, state->size);
+
+    // even again, the value is written before
+    __atomic_store_n(&state->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    for (uint8_t i = 0; i < state->subscriber_count; i++)
+    {
+        ActiveObjectSetFlags(state->subscribers[i], state->flags[i]);
+    }
+}
+
+extern uint32_t SharedStateRead(SharedState_t* state, void* value)
+{
+    uint32_t before;
+    uint32_t after;
+
+    do
+    {
+        before = __atomic_load_n(&state->sequence, __ATOMIC_ACQUIRE);
+
+        // publish in progress, the writer preempted us and finishes before we run again
+        if (before & 1U)
+        {
+            after = before + 1;
+            continue;
+        }
+
+        os_memcpy(value, state->value, state->size);
+
+        // copy is done before the sequence is read again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&state->sequence, __ATOMIC_RELAXED);
+    } while (before != after);
+
+    return before / 2;
+}
+
+extern uint32_t SharedStateVersion(SharedState_t* state)
+{
+    return __atomic_load_n(&state->sequence, __ATOMIC_ACQUIRE) / 2;
+}
+#endif // OS_CFG_SHARED
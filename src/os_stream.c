@@ -0,0 +1,201 @@
+/**
+ * @file os_stream.c
+ */
+
+#include "inc/os_stream.h"
+
+#if OS_CFG_STREAM
+
+static void Notify(Stream_t* stream, uint32_t available);
+
+//! buffer offset of a head or tail count
+#define STREAM_OFFSET(stream, count) ((count) & ((stream)->size - 1U))
+
+extern OSStatus_t StreamInit(Stream_t* stream, uint8_t* buffer, uint32_t size)
+{
+    if (0 == size || 0 != (size & (size - 1U)))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    stream->buffer = buffer;
+    stream->size = size;
+    stream->head = 0;
+    stream->tail = 0;
+    stream->consumer = NULL;
+    stream->flags = 0;
+    stream->threshold = 1;
+    stream->overruns = 0;
+
+    return OS_SUCCESS;
+}
+
+extern OSStatus_t StreamSetConsumer(Stream_t* stream, ActiveObject_t* consumer, uint32_t flags,
+                                    uint32_t threshold)
+{
+    // the consumer reads the stream, a proxy can't
+    if (consumer && AO_IS_PROXY(consumer))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    stream->consumer = consumer;
+    stream->flags = flags;
+    stream->threshold = threshold ? threshold : 1;
+
+    return OS_SUCCESS;
+}
+
+extern uint32_t StreamAvailable(Stream_t* stream)
+{
+    return __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE);
+}
+
+extern uint32_t StreamFree(Stream_t* stream)
+{
+    return stream->size - StreamAvailable(stream);
+}
+
+/**
+ * @brief Readies the consumer if enough data is available
+ *
+ * @param stream
+ * @param available
+ */
+static void Notify(Stream_t* stream, uint32_t available)
+{
+    // flags coalesce, only the first notification before the consumer runs readies it
+    if (stream->consumer && available >= stream->threshold)
+    {
+        ActiveObjectSetFlags(stream->consumer, stream->flags);
+    }
+}
+
+extern uint32_t StreamWriteAcquire(Stream_t* stream, uint8_t** window)
+{
+    uint32_t head = stream->head;
+    uint32_t free = stream->size - (head - __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE));
+    uint32_t linear = stream->size - STREAM_OFFSET(stream, head);
+
+    *window = &stream->buffer[STREAM_OFFSET(stream, head)];
+
+    return (free < linear) ? free : linear;
+}
+
+extern void StreamWriteCommit(Stream_t* stream, uint32_t count)
+{
+    uint32_t head = stream->head + count;
+
+    // data is written before the consumer can see it
+    __atomic_store_n(&stream->head, head, __ATOMIC_RELEASE);
+
+    Notify(stream, head - __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE));
+}
+
+extern uint32_t StreamWrite(Stream_t* stream, const void* data, uint32_t len)
+{
+    const uint8_t* src = (const uint8_t*)data;
+    uint32_t       written = 0;
+
+    // at most two windows, up to the end of the buffer then from its start
+    for (uint8_t i = 0; i < 2 && written < len; i++)
+    {
+        uint8_t* window;
+        uint32_t count = StreamWriteAcquire(stream, &window);
+
+        if (count > len - written)
+        {
+            count = len - written;
+        }
+
+        os_memcpy(window, &src[written], count);
+        __atomic_store_n(&stream->head, stream->head + count, __ATOMIC_RELEASE);
+        written += count;
+    }
+
+    if (written < len)
+    {
+        stream->overruns++;
+    }
+
+    Notify(stream, StreamAvailable(stream));
+
+    return written;
+}
+
+extern void StreamDmaCommit(Stream_t* stream, uint32_t position)
+{
+    uint32_t head = stream->head;
+    uint32_t written = STREAM_OFFSET(stream, position - STREAM_OFFSET(stream, head));
+    uint32_t tail = __atomic_load_n(&stream->tail, __ATOMIC_ACQUIRE);
+
+    // lapped the consumer, the oldest unread data has been overwritten
+    if (head + written - tail > stream->size)
+    {
+        stream->overruns++;
+    }
+
+    head += written;
+    __atomic_store_n(&stream->head, head, __ATOMIC_RELEASE);
+
+    Notify(stream, head - tail);
+}
+
+extern void StreamIdle(Stream_t* stream)
+{
+    if (stream->consumer && StreamAvailable(stream))
+    {
+        ActiveObjectSetFlags(stream->consumer, stream->flags);
+    }
+}
+
+extern uint32_t StreamReadAcquire(Stream_t* stream, const uint8_t** window)
+{
+    uint32_t tail = stream->tail;
+    uint32_t available = __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE) - tail;
+
+    // DMA lapped us, skip to the oldest data not overwritten
+    if (available > stream->size)
+    {
+        tail += available - stream->size;
+        available = stream->size;
+        __atomic_store_n(&stream->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    uint32_t linear = stream->size - STREAM_OFFSET(stream, tail);
+
+    *window = &stream->buffer[STREAM_OFFSET(stream, tail)];
+
+    return (available < linear) ? available : linear;
+}
+
+extern void StreamReadRelease(Stream_t* stream, uint32_t count)
+{
+    // data is read before the producer can reuse the space
+    __atomic_store_n(&stream->tail, stream->tail + count, __ATOMIC_RELEASE);
+}
+
+extern uint32_t StreamRead(Stream_t* stream, void* data, uint32_t len)
+{
+    uint8_t* dest = (uint8_t*)data;
+    uint32_t read = 0;
+
+    for (uint8_t i = 0; i < 2 && read < len; i++)
+    {
+        const uint8_t* window;
+        uint32_t       count = StreamReadAcquire(stream, &window);
+
+        if (count > len - read)
+        {
+            count = len - read;
+        }
+
+        os_memcpy(&dest[read], window, count);
+        StreamReadRelease(stream, count);
+        read += count;
+    }
+
+    return read;
+}
+#endif // OS_CFG_STREAM
@@ -0,0 +1,63 @@
+/**
+ * @file os_time.c
+ */
+
+#include "inc/os_time.h"
+#include "inc/os_port.h"
+
+//! upper word of the 64-bit cycle count
+static uint32_t cycles_high = 0;
+
+//! last counter value read, to detect wraps
+static uint32_t cycles_last = 0;
+
+//! timebase frequency
+static uint32_t cycles_per_us = 1;
+
+extern void OSTimebaseInit(uint32_t cpu_hz)
+{
+    cycles_per_us = cpu_hz / 1000000U;
+
+    if (0 == cycles_per_us)
+    {
+        cycles_per_us = 1;
+    }
+
+    cycles_high = 0;
+    cycles_last = 0;
+
+    OSPortCycleCounterInit();
+}
+
+extern uint64_t OSGetCycles()
+{
+    uint32_t primask;
+
+    // both words have to be read and updated together, callers may have interrupts disabled
+    CRITICAL_SECTION_ENTER(primask);
+
+    uint32_t now = OSPortCycleCounterRead();
+
+    if (now < cycles_last)
+    {
+        cycles_high++;
+    }
+
+    cycles_last = now;
+
+    uint64_t cycles = ((uint64_t)cycles_high << 32) | now;
+
+    CRITICAL_SECTION_EXIT(primask);
+
+    return cycles;
+}
+
+extern uint64_t OSGetTimeUs()
+{
+    return OSGetCycles() / cycles_per_us;
+}
+
+extern uint64_t OSTimeUsToCycles(uint32_t us)
+{
+    return (uint64_t)us * cycles_per_us;
+}
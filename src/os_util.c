@@ -6,11 +6,64 @@
 
 #include <stdint.h>
 
+//! below this, setting up the word loop costs more than it saves
+#define OS_MEMCPY_BYTE_THRESHOLD 8U
+
 extern void* os_memcpy(void* dest, const void* src, uint32_t len)
 {
     uint8_t*       d = (uint8_t*)dest;
     const uint8_t* s = (uint8_t*)src;
 
+    if (len >= OS_MEMCPY_BYTE_THRESHOLD)
+    {
+        // head, up to an aligned destination
+        while ((uintptr_t)d & 3U)
+        {
+            *d++ = *s++;
+            len--;
+        }
+
+        os_word_t* dw = (os_word_t*)d;
+
+        if (0 == ((uintptr_t)s & 3U))
+        {
+            const os_word_t* sw = (const os_word_t*)s;
+
+            // 16 bytes per iteration, load/store multiple on Cortex-M
+            for (; len >= 16U; len -= 16U)
+            {
+                dw[0] = sw[0];
+                dw[1] = sw[1];
+                dw[2] = sw[2];
+                dw[3] = sw[3];
+                dw += 4;
+                sw += 4;
+            }
+
+            for (; len >= 4U; len -= 4U)
+            {
+                *dw++ = *sw++;
+            }
+
+            s = (const uint8_t*)sw;
+        }
+        else
+        {
+            // source misaligned, Cortex-M4 loads unaligned words in hardware
+            const os_unaligned_word_t* sw = (const os_unaligned_word_t*)s;
+
+            for (; len >= 4U; len -= 4U)
+            {
+                *dw++ = *sw++;
+            }
+
+            s = (const uint8_t*)sw;
+        }
+
+        d = (uint8_t*)dw;
+    }
+
+    // tail
     while (len--)
     {
         *d++ = *s++;
@@ -3,6 +3,14 @@
  */
 
 #include "inc/state_machine.h"
+#include "inc/os_msg.h"
+
+#if OS_CFG_STATE_MACHINE
+
+static void CommandGroupOnStart(Command_t* cmd, void* instance_data);
+static bool CommandGroupOnMessage(Command_t* cmd, Message_t* msg, void* instance_data);
+static void CommandGroupOnEnd(Command_t* cmd, void* instance_data);
+static bool CommandGroupIsJoined(CommandGroup_t* group);
 
 extern void StateMachineInit(StateMachine_t* sm, Command_t* start)
 {
@@ -62,3 +70,159 @@ extern bool StateMachineStep(StateMachine_t* sm, Message_t* msg, void* instance_
     // false if current command is not done (sequential states)
     return false;
 }
+
+extern bool CommandDispatch(const CommandDispatchTable_t* table, Command_t* cmd, Message_t* msg,
+                            void* instance_data)
+{
+    // same bounds check trick as MessageDispatchLookup
+    uint32_t                index = msg->id - table->base_id;
+    CommandMessageHandler_f handler = table->default_handler;
+
+    if (index < table->count && table->handlers[index])
+    {
+        handler = table->handlers[index];
+    }
+
+    if (!handler)
+    {
+        return false;
+    }
+
+    return handler(cmd, msg, instance_data);
+}
+
+extern OSStatus_t CommandGroupInit(CommandGroup_t* group, Command_t** children, uint8_t count,
+                                   CommandJoin_t join, uint32_t join_mask, Command_t* next)
+{
+    if (count > COMMAND_GROUP_MAX_CHILDREN)
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    // a bit without a child would never be done
+    if (COMMAND_JOIN_MASK == join && count < COMMAND_GROUP_MAX_CHILDREN && (join_mask >> count))
+    {
+        return OS_INVALID_ARGUMENT;
+    }
+
+    group->base.on_Start = CommandGroupOnStart;
+    group->base.on_Message = CommandGroupOnMessage;
+    group->base.on_End = CommandGroupOnEnd;
+    group->base.end_behavior = COMMAND_ON_END_WAIT_FOR_END;
+    group->base.next = next;
+
+    group->children = children;
+    group->count = count;
+    group->join = join;
+    group->join_mask = join_mask;
+    group->active_mask = 0;
+    group->done_mask = 0;
+
+    return OS_SUCCESS;
+}
+
+static bool CommandGroupIsJoined(CommandGroup_t* group)
+{
+    switch (group->join)
+    {
+        case COMMAND_JOIN_ANY:
+            return 0 != group->done_mask || 0 == group->count;
+        case COMMAND_JOIN_MASK:
+            return (group->done_mask & group->join_mask) == group->join_mask;
+        case COMMAND_JOIN_ALL:
+        default:
+            return 0 == group->active_mask;
+    }
+}
+
+static void CommandGroupOnStart(Command_t* cmd, void* instance_data)
+{
+    CommandGroup_t* group = (CommandGroup_t*)cmd;
+
+    group->active_mask = 0;
+    group->done_mask = 0;
+    group->base.end_behavior = COMMAND_ON_END_WAIT_FOR_END;
+
+    // fork
+    for (uint8_t i = 0; i < group->count; i++)
+    {
+        Command_t* child = group->children[i];
+
+        child->on_Start(child, instance_data);
+
+        // same as StateMachineStart, instant commands are done without on_End
+        if (COMMAND_ON_END_INSTANT == child->end_behavior)
+        {
+            group->done_mask |= (1U << i);
+        }
+        else
+        {
+            group->active_mask |= (1U << i);
+        }
+    }
+
+    // nothing to wait for, state machine moves on without calling on_End
+    if (CommandGroupIsJoined(group))
+    {
+        CommandGroupOnEnd(cmd, instance_data);
+        group->base.end_behavior = COMMAND_ON_END_INSTANT;
+    }
+}
+
+static bool CommandGroupOnMessage(Command_t* cmd, Message_t* msg, void* instance_data)
+{
+    CommandGroup_t* group = (CommandGroup_t*)cmd;
+
+    // deliver to every running child
+    for (uint8_t i = 0; i < group->count; i++)
+    {
+        uint32_t   bit = 1U << i;
+        Command_t* child = group->children[i];
+
+        if (!(group->active_mask & bit))
+        {
+            continue;
+        }
+
+        bool is_done = true;
+
+        if (child->on_Message)
+        {
+            is_done = child->on_Message(child, msg, instance_data);
+        }
+
+        if (is_done)
+        {
+            group->active_mask &= ~bit;
+            group->done_mask |= bit;
+
+            if (child->on_End)
+            {
+                child->on_End(child, instance_data);
+            }
+        }
+    }
+
+    // join
+    return CommandGroupIsJoined(group);
+}
+
+static void CommandGroupOnEnd(Command_t* cmd, void* instance_data)
+{
+    CommandGroup_t* group = (CommandGroup_t*)cmd;
+
+    // end children that were still running when the join condition held
+    for (uint8_t i = 0; i < group->count; i++)
+    {
+        uint32_t   bit = 1U << i;
+        Command_t* child = group->children[i];
+
+        if ((group->active_mask & bit) && child->on_End)
+        {
+            child->on_End(child, instance_data);
+        }
+    }
+
+    group->active_mask = 0;
+}
+#endif // OS_CFG_STATE_MACHINE
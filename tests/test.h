@@ -0,0 +1,22 @@
+/**
+ * @file test.h
+ *
+ * Checks for the host tests
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//! fails the test, unlike assert it stays in release builds
+#define CHECK(X)                                                                                   \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(X))                                                                                  \
+        {                                                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #X);                  \
+            exit(1);                                                                               \
+        }                                                                                          \
+    } while (false)
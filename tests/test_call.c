@@ -0,0 +1,155 @@
+/**
+ * @file test_call.c
+ *
+ * Asynchronous calls: the caller gets the reply or the timeout, never both, replies with the
+ * token of a call that timed out, was cancelled or was answered already are rejected, and a
+ * timeout that didn't fit the caller's queue is posted again on the next tick.
+ */
+
+#include "inc/os_call.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define REQUEST_MSG_ID 1
+#define REPLY_MSG_ID   2
+#define FILLER_MSG_ID  3
+
+ACTIVE_OBJECT_DECL(caller, 2)
+ACTIVE_OBJECT_DECL(callee, 4)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+//! copy of the last request the callee took
+static CallMessage_t request;
+static int           requests = 0;
+
+//! replies and timeouts the caller got, and the token of the last one
+static int         replies = 0;
+static int         timeouts = 0;
+static CallToken_t answered = OS_CALL_TOKEN_NONE;
+
+static void Caller(Message_t* msg)
+{
+    if (REPLY_MSG_ID == msg->id)
+    {
+        replies++;
+        answered = ((CallMessage_t*)msg)->token;
+    }
+    else if (OS_CALL_TIMEOUT_MSG_ID == msg->id)
+    {
+        timeouts++;
+        answered = ((CallMessage_t*)msg)->token;
+    }
+}
+
+static void Callee(Message_t* msg)
+{
+    CHECK(REQUEST_MSG_ID == msg->id);
+
+    memcpy(&request, msg, sizeof(request));
+    requests++;
+}
+
+/**
+ * @brief Requests a call from caller to callee and lets the callee take it
+ *
+ * @param timeout_ms
+ * @return CallToken_t
+ */
+static CallToken_t Request(uint32_t timeout_ms)
+{
+    CallMessage_t msg = {{REQUEST_MSG_ID, sizeof(CallMessage_t)}, OS_CALL_TOKEN_NONE};
+    CallToken_t   token = OSCallRequest(&caller, &callee, &msg, timeout_ms);
+    int           taken = requests;
+
+    CHECK(OS_CALL_TOKEN_NONE != token && OSCallIsPending(token));
+    SchedulerActivateAO();
+    CHECK(taken + 1 == requests && token == request.token);
+
+    return token;
+}
+
+static OSStatus_t Reply(const CallMessage_t* to)
+{
+    CallMessage_t reply = {{REPLY_MSG_ID, sizeof(CallMessage_t)}, OS_CALL_TOKEN_NONE};
+    OSStatus_t    status = OSCallReply(to, &reply);
+
+    SchedulerActivateAO();
+
+    return status;
+}
+
+static void Ticks(int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        OSPortHostTick();
+    }
+}
+
+int main()
+{
+    KernelInit(&os, &callbacks);
+    AO_INIT(caller, 1, Caller, 2, 0);
+    AO_INIT(callee, 2, Callee, 4, 1);
+
+    // answered in time, the timeout never comes
+    CallToken_t token = Request(5);
+
+    CHECK(OS_SUCCESS == Reply(&request));
+    CHECK(1 == replies && token == answered && !OSCallIsPending(token));
+    Ticks(10);
+    CHECK(0 == timeouts);
+
+    // a second reply to the same request is stale
+    CHECK(OS_INVALID_ARGUMENT == Reply(&request));
+    CHECK(1 == replies);
+
+    // not answered, it times out on the fifth tick and the late reply is rejected
+    token = Request(5);
+    Ticks(4);
+    CHECK(0 == timeouts && OSCallIsPending(token));
+    Ticks(1);
+    CHECK(1 == timeouts && token == answered && !OSCallIsPending(token));
+    CHECK(OS_INVALID_ARGUMENT == Reply(&request));
+    CHECK(1 == replies);
+
+    // the slot is taken again with another generation, the old token can't answer the new call
+    CallMessage_t old = request;
+
+    token = Request(0);
+    CHECK(token != old.token && OS_INVALID_ARGUMENT == Reply(&old));
+    CHECK(OSCallIsPending(token) && 1 == replies);
+
+    // waits forever until answered
+    Ticks(100);
+    CHECK(1 == timeouts && OSCallIsPending(token));
+    CHECK(OS_SUCCESS == Reply(&request) && 2 == replies);
+
+    // cancelled, neither the timeout nor the reply reach the caller
+    token = Request(5);
+    CHECK(OSCallCancel(token) && !OSCallCancel(token) && !OSCallIsPending(token));
+    Ticks(10);
+    CHECK(OS_INVALID_ARGUMENT == Reply(&request));
+    CHECK(1 == timeouts && 2 == replies);
+
+    // the caller's queue is full when it expires, the next tick posts it
+    Message_t filler = {FILLER_MSG_ID, sizeof(Message_t)};
+
+    token = Request(5);
+    Ticks(4);
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&caller, &filler));
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&caller, &filler));
+    Ticks(1);
+    CHECK(1 == timeouts && OSCallIsPending(token));
+    Ticks(1);
+    CHECK(2 == timeouts && token == answered && !OSCallIsPending(token));
+    CHECK(OS_INVALID_ARGUMENT == Reply(&request));
+
+    printf("test_call: ok\n");
+
+    return 0;
+}
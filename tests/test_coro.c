@@ -0,0 +1,150 @@
+/**
+ * @file test_coro.c
+ *
+ * Coroutines of one AO sharing a timer: awaits end on their message or their timeout, a timeout
+ * queued behind the message that ended its await is ignored, and the shared timer serves the
+ * other coroutine once free.
+ */
+
+#include "inc/os_coro.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#define START_MSG_ID   1
+#define ACK_MSG_ID     2
+#define GO_MSG_ID      3
+#define TIMEOUT_MSG_ID 4
+#define STALL_MSG_ID   5
+
+ACTIVE_OBJECT_DECL(worker, 8)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+static CoroutineTimer_t timer;
+static Coroutine_t      sender;
+static Coroutine_t      waiter;
+
+static int  acks = 0;
+static int  timeouts = 0;
+static bool delayed = false;
+
+static void Sender(Coroutine_t* co, Message_t* msg)
+{
+    CORO_BEGIN(co);
+
+    CORO_AWAIT_MSG_TIMEOUT(co, msg, ACK_MSG_ID, 10);
+    CHECK(!CORO_TIMED_OUT(co));
+    acks++;
+
+    CORO_AWAIT_MSG_TIMEOUT(co, msg, ACK_MSG_ID, 10);
+    CHECK(!CORO_TIMED_OUT(co));
+    acks++;
+
+    CORO_AWAIT_MSG_TIMEOUT(co, msg, ACK_MSG_ID, 10);
+    CHECK(CORO_TIMED_OUT(co));
+    timeouts++;
+
+    CORO_END(co);
+}
+
+static void Waiter(Coroutine_t* co, Message_t* msg)
+{
+    CORO_BEGIN(co);
+
+    CORO_AWAIT_MSG(co, msg, GO_MSG_ID);
+    CORO_DELAY(co, msg, 5);
+    delayed = true;
+
+    CORO_END(co);
+}
+
+static void Worker(Message_t* msg)
+{
+    // ticks while the AO runs queue their timeouts behind the messages already posted
+    if (STALL_MSG_ID == msg->id)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            OSPortHostTick();
+        }
+
+        return;
+    }
+
+    Sender(&sender, msg);
+    Waiter(&waiter, msg);
+}
+
+static void Post(uint32_t id)
+{
+    Message_t msg = {id, sizeof(Message_t)};
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&worker, &msg));
+}
+
+static void Ticks(int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        OSPortHostTick();
+        SchedulerActivateAO();
+    }
+}
+
+int main()
+{
+    // resume line, awaited id and a pointer, the timed event lives in the shared timer
+    CHECK(sizeof(Coroutine_t) <= 2 * sizeof(uint32_t) + sizeof(void*));
+
+    KernelInit(&os, &callbacks);
+    AO_INIT(worker, 1, Worker, 8, 0);
+    CoroutineTimerInit(&timer, &worker, TIMEOUT_MSG_ID);
+    CoroutineInit(&sender, &timer);
+    CoroutineInit(&waiter, &timer);
+
+    Post(START_MSG_ID);
+    SchedulerActivateAO();
+
+    // first await ends on its ack
+    Ticks(3);
+    Post(ACK_MSG_ID);
+    SchedulerActivateAO();
+    CHECK(1 == acks && 0 == timeouts);
+
+    // the second times out while its ack is still queued: the ack ends the await, the queued
+    // timeout behind it is stale
+    Post(STALL_MSG_ID);
+    Post(ACK_MSG_ID);
+    SchedulerActivateAO();
+    CHECK(2 == acks && 0 == timeouts);
+
+    // the third gets no ack, nine ticks in it still waits, the tenth times it out
+    Ticks(9);
+    CHECK(0 == timeouts);
+    Ticks(1);
+    CHECK(1 == timeouts && CoroutineIsDone(&sender));
+
+    // the other coroutine saw that timeout as well, it wasn't its own
+    CHECK(GO_MSG_ID == waiter.wait_id && !CORO_TIMED_OUT(&waiter));
+
+    // the timer is free, the other coroutine delays with it
+    Post(GO_MSG_ID);
+    SchedulerActivateAO();
+    Ticks(4);
+    CHECK(!delayed);
+    Ticks(1);
+    CHECK(delayed && CoroutineIsDone(&waiter));
+
+    // reset restarts the body, and cancels the timeout of an await in progress
+    CoroutineReset(&sender);
+    Post(START_MSG_ID);
+    SchedulerActivateAO();
+    CoroutineReset(&sender);
+    Ticks(20);
+    CHECK(1 == timeouts && 0 == sender.line && NULL == timer.owner);
+
+    printf("test_coro: ok\n");
+
+    return 0;
+}
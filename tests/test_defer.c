@@ -0,0 +1,97 @@
+/**
+ * @file test_defer.c
+ *
+ * Deferred calls: argument checks, priority order against AOs, and calls deferred by an ISR
+ * while an AO runs, which wait for it instead of preempting it.
+ */
+
+#include "inc/os_defer.h"
+#include "inc/os.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define RUN_MSG_ID 1
+
+ACTIVE_OBJECT_DECL(worker, 4)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+//! order things ran in, one letter each
+static char trace[16];
+static int  traced = 0;
+
+static int  handler_depth = 0;
+static bool raise_isr = false;
+
+static void Trace(char c)
+{
+    CHECK(traced < (int)sizeof(trace) - 1);
+    trace[traced++] = c;
+}
+
+static void Call(void* arg)
+{
+    // never inside the AO's handler
+    CHECK(0 == handler_depth);
+    Trace(*(const char*)arg);
+}
+
+static void DeferIsr()
+{
+    OS_ISR_ENTER(&os);
+    CHECK(OS_SUCCESS == DeferCall(Call, "d", 2));
+    OS_ISR_EXIT(&os);
+}
+
+static void Worker(Message_t* msg)
+{
+    CHECK(RUN_MSG_ID == msg->id);
+
+    handler_depth++;
+    Trace('w');
+
+    if (raise_isr)
+    {
+        raise_isr = false;
+        OSPortHostIsr(DeferIsr);
+    }
+
+    handler_depth--;
+}
+
+int main()
+{
+    Message_t run = {RUN_MSG_ID, sizeof(Message_t)};
+
+    KernelInit(&os, &callbacks);
+    AO_INIT(worker, 5, Worker, 4, 0);
+
+    // reserved, it would read as an empty list and never run
+    CHECK(OS_INVALID_ARGUMENT == DeferCall(Call, "x", OS_DEFER_NONE));
+    CHECK(OS_DEFER_NONE == DeferHighestPriority());
+
+    // highest priority first, then an AO after calls of its own priority
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&worker, &run));
+    CHECK(OS_SUCCESS == DeferCall(Call, "c", 7));
+    CHECK(OS_SUCCESS == DeferCall(Call, "b", 5));
+    CHECK(OS_SUCCESS == DeferCall(Call, "a", 1));
+    SchedulerActivateAO();
+    CHECK(0 == strcmp("abwc", trace));
+
+    // deferred by an ISR while the AO runs: after its handler, and its message is handled once
+    traced = 0;
+    memset(trace, 0, sizeof(trace));
+    raise_isr = true;
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&worker, &run));
+    SchedulerActivateAO();
+    CHECK(0 == strcmp("wd", trace));
+    CHECK(!SchedulerHasReady() && OS_DEFER_NONE == DeferHighestPriority());
+
+    printf("test_defer: ok\n");
+
+    return 0;
+}
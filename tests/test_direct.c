@@ -0,0 +1,133 @@
+/**
+ * @file test_direct.c
+ *
+ * Direct dispatch and ready order: a post runs the receiver inline only if nothing would run
+ * before it, AOs and deferred calls of its own priority readied first included, and ready AOs
+ * run by priority, in the order they were readied within one priority.
+ */
+
+#include "inc/os_defer.h"
+#include "inc/os.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define RUN_MSG_ID 1
+
+//! what the sender posts, see Sender
+typedef enum Case_e
+{
+    CASE_DIRECT = 0,
+    CASE_PEER_FIRST,
+    CASE_DEFER_FIRST,
+    CASE_ORDER,
+} Case_t;
+
+ACTIVE_OBJECT_DECL(sender, 4)
+ACTIVE_OBJECT_DECL(fast, 4)
+ACTIVE_OBJECT_DECL(peer, 4)
+ACTIVE_OBJECT_DECL(low, 4)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+//! order things ran in, one letter each
+static char trace[16];
+static int  traced = 0;
+
+static Message_t run = {RUN_MSG_ID, sizeof(Message_t)};
+
+static void Trace(char c)
+{
+    CHECK(traced < (int)sizeof(trace) - 1);
+    trace[traced++] = c;
+}
+
+static void Call(void* arg)
+{
+    Trace(*(const char*)arg);
+}
+
+static void Sender(Message_t* msg)
+{
+    Trace('S');
+
+    switch ((Case_t)((DataMessage_t*)msg)->data)
+    {
+        case CASE_DIRECT:
+            CHECK(MSG_Q_SUCCESS == MsgQueuePut(&fast, &run));
+            break;
+
+        case CASE_PEER_FIRST:
+            CHECK(MSG_Q_SUCCESS == MsgQueuePut(&peer, &run));
+            CHECK(MSG_Q_SUCCESS == MsgQueuePut(&fast, &run));
+            break;
+
+        case CASE_DEFER_FIRST:
+            CHECK(OS_SUCCESS == DeferCall(Call, "d", fast.priority));
+            CHECK(MSG_Q_SUCCESS == MsgQueuePut(&fast, &run));
+            break;
+
+        case CASE_ORDER:
+            CHECK(MSG_Q_SUCCESS == MsgQueuePut(&peer, &run));
+            CHECK(MSG_Q_SUCCESS == MsgQueuePut(&low, &run));
+            CHECK(MSG_Q_SUCCESS == MsgQueuePut(&fast, &run));
+            break;
+    }
+
+    Trace('E');
+}
+
+static void Fast(Message_t* msg)
+{
+    Trace('f');
+}
+
+static void Peer(Message_t* msg)
+{
+    Trace('p');
+}
+
+static void Low(Message_t* msg)
+{
+    Trace('l');
+}
+
+static const char* RunCase(Case_t c)
+{
+    DataMessage_t msg = {{RUN_MSG_ID, sizeof(DataMessage_t)}, 0, c};
+
+    traced = 0;
+    memset(trace, 0, sizeof(trace));
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&sender, &msg));
+    SchedulerActivateAO();
+    CHECK(!SchedulerHasReady());
+
+    return trace;
+}
+
+int main()
+{
+    KernelInit(&os, &callbacks);
+    AO_INIT(sender, 5, Sender, 4, 0);
+    AO_INIT(fast, 2, Fast, 4, 1);
+    AO_INIT(peer, 2, Peer, 4, 2);
+    AO_INIT(low, 3, Low, 4, 3);
+    ActiveObjectSetDirect(&fast, true);
+
+    // nothing else ready, runs inline like a function call
+    CHECK(0 == strcmp("SfE", RunCase(CASE_DIRECT)));
+
+    // an AO or deferred call of the same priority readied first runs first
+    CHECK(0 == strcmp("SEpf", RunCase(CASE_PEER_FIRST)));
+    CHECK(0 == strcmp("SEdf", RunCase(CASE_DEFER_FIRST)));
+
+    // by priority, then in the order readied
+    CHECK(0 == strcmp("SEpfl", RunCase(CASE_ORDER)));
+
+    printf("test_direct: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,217 @@
+/**
+ * @file test_dispatch.c
+ *
+ * Dispatch tables: mapped ids reach their handler, unmapped ids and ids below or above the table
+ * reach the default handler or nothing, a table set on an AO replaces the previous one or its
+ * handler, and command tables do the same for on_Message.
+ */
+
+#include "inc/os.h"
+#include "inc/state_machine.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define APP_MSG_BASE  10
+#define START_MSG_ID  10
+#define PAUSE_MSG_ID  11
+#define STOP_MSG_ID   12
+#define APP_MSG_COUNT 4
+
+//! handlers in the order they ran, one letter each
+static char trace[32];
+static int  traced = 0;
+
+static void Trace(char c)
+{
+    CHECK(traced < (int)sizeof(trace) - 1);
+    trace[traced++] = c;
+}
+
+static void ResetTrace()
+{
+    memset(trace, 0, sizeof(trace));
+    traced = 0;
+}
+
+static void OnStart(Message_t* msg)
+{
+    UNUSED(msg);
+    Trace('s');
+}
+
+static void OnStop(Message_t* msg)
+{
+    UNUSED(msg);
+    Trace('p');
+}
+
+static void OnDefault(Message_t* msg)
+{
+    UNUSED(msg);
+    Trace('d');
+}
+
+static void OnOther(Message_t* msg)
+{
+    UNUSED(msg);
+    Trace('o');
+}
+
+static void Plain(Message_t* msg)
+{
+    UNUSED(msg);
+    Trace('h');
+}
+
+// PAUSE and the last slot are unmapped
+MSG_DISPATCH_TABLE_DECL(app_table, APP_MSG_BASE, APP_MSG_COUNT, OnDefault,
+                        MSG_DISPATCH_ENTRY(APP_MSG_BASE, START_MSG_ID, OnStart),
+                        MSG_DISPATCH_ENTRY(APP_MSG_BASE, STOP_MSG_ID, OnStop))
+
+// no default handler, only PAUSE
+MSG_DISPATCH_TABLE_DECL(pause_table, APP_MSG_BASE, APP_MSG_COUNT, NULL,
+                        MSG_DISPATCH_ENTRY(APP_MSG_BASE, PAUSE_MSG_ID, OnOther))
+
+static bool CmdOnStart(Command_t* cmd, Message_t* msg, void* instance_data)
+{
+    UNUSED(cmd);
+    UNUSED(msg);
+    UNUSED(instance_data);
+    Trace('s');
+
+    return false;
+}
+
+static bool CmdOnStop(Command_t* cmd, Message_t* msg, void* instance_data)
+{
+    UNUSED(cmd);
+    UNUSED(msg);
+    UNUSED(instance_data);
+    Trace('p');
+
+    return true;
+}
+
+static bool CmdOnDefault(Command_t* cmd, Message_t* msg, void* instance_data)
+{
+    UNUSED(cmd);
+    UNUSED(msg);
+    UNUSED(instance_data);
+    Trace('d');
+
+    return false;
+}
+
+CMD_DISPATCH_TABLE_DECL(cmd_table, APP_MSG_BASE, APP_MSG_COUNT, CmdOnDefault,
+                        MSG_DISPATCH_ENTRY(APP_MSG_BASE, START_MSG_ID, CmdOnStart),
+                        MSG_DISPATCH_ENTRY(APP_MSG_BASE, STOP_MSG_ID, CmdOnStop))
+
+CMD_DISPATCH_TABLE_DECL(bare_table, APP_MSG_BASE, APP_MSG_COUNT, NULL,
+                        MSG_DISPATCH_ENTRY(APP_MSG_BASE, STOP_MSG_ID, CmdOnStop))
+
+ACTIVE_OBJECT_DECL(table_ao, 8)
+ACTIVE_OBJECT_DECL(plain_ao, 8)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+/**
+ * @brief Posts messages with the given ids to the AO and runs it
+ *
+ * @param ao
+ * @param ids
+ * @param count
+ */
+static void Post(ActiveObject_t* ao, const uint32_t* ids, int count)
+{
+    ResetTrace();
+
+    for (int i = 0; i < count; i++)
+    {
+        Message_t msg = {ids[i], sizeof(Message_t)};
+
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(ao, &msg));
+    }
+
+    SchedulerActivateAO();
+}
+
+int main()
+{
+    // below the base, mapped, unmapped, mapped, unmapped last slot, past the end
+    static const uint32_t ids[] = {APP_MSG_BASE - 1, START_MSG_ID, PAUSE_MSG_ID,
+                                   STOP_MSG_ID,      13,           APP_MSG_BASE + APP_MSG_COUNT};
+    const int             id_count = sizeof(ids) / sizeof(ids[0]);
+    Message_t             msg = {PAUSE_MSG_ID, sizeof(Message_t)};
+    Command_t             cmd = {NULL, NULL, NULL, COMMAND_ON_END_WAIT_FOR_END, NULL};
+
+    KernelInit(&os, &callbacks);
+    AO_INIT_DISPATCH(table_ao, 1, &app_table, 8, 0);
+    AO_INIT(plain_ao, 2, Plain, 8, 1);
+
+    // ids without an entry and outside the table go to the default handler
+    Post(&table_ao, ids, id_count);
+    CHECK(0 == strcmp("dsdpdd", trace));
+
+    CHECK(MessageDispatch(&app_table, &msg) && 'd' == trace[traced - 1]);
+    CHECK(OnDefault == MessageDispatchLookup(&app_table, 0xFFFFFFFFU));
+    CHECK(OnStart == MessageDispatchLookup(&app_table, START_MSG_ID));
+
+    // without a default they are dropped
+    ResetTrace();
+    CHECK(MessageDispatch(&pause_table, &msg) && 0 == strcmp("o", trace));
+    msg.id = STOP_MSG_ID;
+    CHECK(!MessageDispatch(&pause_table, &msg) && 1 == traced);
+    CHECK(NULL == MessageDispatchLookup(&pause_table, APP_MSG_BASE - 1));
+
+    // replaced, the messages already queued go through the new table
+    ResetTrace();
+
+    for (int i = 0; i < id_count; i++)
+    {
+        msg.id = ids[i];
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(&table_ao, &msg));
+    }
+
+    ActiveObjectSetDispatch(&table_ao, &pause_table);
+    SchedulerActivateAO();
+    CHECK(0 == strcmp("o", trace));
+
+    // a table set on an AO with a handler takes over, NULL hands messages back to the handler
+    ActiveObjectSetDispatch(&plain_ao, &app_table);
+    Post(&plain_ao, ids, 2);
+    CHECK(0 == strcmp("ds", trace));
+    ActiveObjectSetDispatch(&plain_ao, NULL);
+    Post(&plain_ao, ids, 2);
+    CHECK(0 == strcmp("hh", trace));
+
+    // command tables: unmapped and out of range ids reach the default, which keeps it running
+    ResetTrace();
+    cmd.on_Message = cmd_table_OnMessage;
+
+    for (int i = 0; i < id_count; i++)
+    {
+        msg.id = ids[i];
+        CHECK((STOP_MSG_ID == ids[i]) == cmd.on_Message(&cmd, &msg, NULL));
+    }
+
+    CHECK(0 == strcmp("dsdpdd", trace));
+
+    // without a default those ids leave the command running
+    ResetTrace();
+    cmd.on_Message = bare_table_OnMessage;
+
+    for (int i = 0; i < id_count; i++)
+    {
+        msg.id = ids[i];
+        CHECK((STOP_MSG_ID == ids[i]) == cmd.on_Message(&cmd, &msg, NULL));
+    }
+
+    CHECK(0 == strcmp("p", trace));
+
+    printf("test_dispatch: ok\n");
+
+    return 0;
+}
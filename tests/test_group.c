@@ -0,0 +1,186 @@
+/**
+ * @file test_group.c
+ *
+ * Parallel command groups: ALL, ANY and MASK joins, instant children and groups, the order of
+ * on_End calls, and the arguments CommandGroupInit rejects.
+ */
+
+#include "inc/os_msg.h"
+#include "inc/state_machine.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+typedef struct TestCommand_s
+{
+    Command_t base;
+    char      name; //!< traced lower case on start, upper case on end
+    bool      instant;
+    int       messages; //!< messages until done
+    int       left;
+} TestCommand_t;
+
+//! starts and ends, one letter each
+static char trace[32];
+static int  traced = 0;
+
+static void Trace(char c)
+{
+    CHECK(traced < (int)sizeof(trace) - 1);
+    trace[traced++] = c;
+}
+
+static void ResetTrace()
+{
+    memset(trace, 0, sizeof(trace));
+    traced = 0;
+}
+
+static void TestOnStart(Command_t* cmd, void* instance_data)
+{
+    TestCommand_t* test = (TestCommand_t*)cmd;
+
+    UNUSED(instance_data);
+    Trace(test->name);
+
+    test->left = test->messages;
+    cmd->end_behavior = test->instant ? COMMAND_ON_END_INSTANT : COMMAND_ON_END_WAIT_FOR_END;
+}
+
+static bool TestOnMessage(Command_t* cmd, Message_t* msg, void* instance_data)
+{
+    TestCommand_t* test = (TestCommand_t*)cmd;
+
+    UNUSED(msg);
+    UNUSED(instance_data);
+
+    return 0 == --test->left;
+}
+
+static void TestOnEnd(Command_t* cmd, void* instance_data)
+{
+    UNUSED(instance_data);
+    Trace((char)(((TestCommand_t*)cmd)->name - 'a' + 'A'));
+}
+
+static void TestInit(TestCommand_t* test, char name, int messages, bool instant)
+{
+    test->base.on_Start = TestOnStart;
+    test->base.on_Message = TestOnMessage;
+    test->base.on_End = TestOnEnd;
+    test->base.end_behavior = COMMAND_ON_END_WAIT_FOR_END;
+    test->base.next = NULL;
+    test->name = name;
+    test->instant = instant;
+    test->messages = messages;
+}
+
+static TestCommand_t  a, b, c, z;
+static Command_t*     children[] = {&a.base, &b.base, &c.base};
+static CommandGroup_t group;
+static StateMachine_t sm;
+static Message_t      msg = {1, sizeof(Message_t)};
+
+/**
+ * @brief Runs the group until the state machine is done
+ *
+ * @return int messages it took
+ */
+static int Run()
+{
+    int steps = 0;
+
+    ResetTrace();
+    StateMachineInit(&sm, &group.base);
+    StateMachineStart(&sm, NULL);
+
+    while (sm.current)
+    {
+        CHECK(steps < 10);
+        steps++;
+
+        if (StateMachineStep(&sm, &msg, NULL))
+        {
+            break;
+        }
+    }
+
+    return steps;
+}
+
+int main()
+{
+    // every child, the instant one gets no on_End
+    TestInit(&a, 'a', 1, false);
+    TestInit(&b, 'b', 2, false);
+    TestInit(&c, 'c', 0, true);
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, 3, COMMAND_JOIN_ALL, 0, NULL));
+    CHECK(2 == Run());
+    CHECK(0 == strcmp("abcAB", trace));
+
+    // the first child done ends the others
+    TestInit(&a, 'a', 1, false);
+    TestInit(&b, 'b', 3, false);
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, 2, COMMAND_JOIN_ANY, 0, NULL));
+    CHECK(1 == Run());
+    CHECK(0 == strcmp("abAB", trace));
+
+    // only b is waited for, a and c end with the group in index order
+    TestInit(&a, 'a', 3, false);
+    TestInit(&b, 'b', 1, false);
+    TestInit(&c, 'c', 2, false);
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, 3, COMMAND_JOIN_MASK, 1U << 1, NULL));
+    CHECK(1 == Run());
+    CHECK(0 == strcmp("abcBAC", trace));
+
+    // children done at different times end when they finish
+    TestInit(&a, 'a', 2, false);
+    TestInit(&b, 'b', 1, false);
+    TestInit(&c, 'c', 3, false);
+    CHECK(OS_SUCCESS ==
+          CommandGroupInit(&group, children, 3, COMMAND_JOIN_MASK, (1U << 0) | (1U << 1), NULL));
+    CHECK(2 == Run());
+    CHECK(0 == strcmp("abcBAC", trace));
+
+    // only instant children, the group is instant and the next command starts right away
+    TestInit(&a, 'a', 0, true);
+    TestInit(&b, 'b', 0, true);
+    TestInit(&z, 'z', 1, false);
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, 2, COMMAND_JOIN_ALL, 0, &z.base));
+    ResetTrace();
+    StateMachineInit(&sm, &group.base);
+    StateMachineStart(&sm, NULL);
+    CHECK(&z.base == sm.current && COMMAND_ON_END_INSTANT == group.base.end_behavior);
+    CHECK(StateMachineStep(&sm, &msg, NULL));
+    CHECK(0 == strcmp("abzZ", trace));
+
+    // an instant child joins ANY at the start, the running one ends with the group
+    TestInit(&b, 'b', 5, false);
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, 2, COMMAND_JOIN_ANY, 0, &z.base));
+    ResetTrace();
+    StateMachineInit(&sm, &group.base);
+    StateMachineStart(&sm, NULL);
+    CHECK(&z.base == sm.current && 0 == strcmp("abBz", trace));
+
+    // started again with a running child, the group waits again
+    TestInit(&a, 'a', 1, false);
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, 1, COMMAND_JOIN_ALL, 0, NULL));
+    group.base.end_behavior = COMMAND_ON_END_INSTANT;
+    ResetTrace();
+    StateMachineInit(&sm, &group.base);
+    StateMachineStart(&sm, NULL);
+    CHECK(&group.base == sm.current && COMMAND_ON_END_WAIT_FOR_END == group.base.end_behavior);
+
+    // too many children, or a mask bit without a child
+    CHECK(OS_INVALID_ARGUMENT == CommandGroupInit(&group, children, COMMAND_GROUP_MAX_CHILDREN + 1,
+                                                  COMMAND_JOIN_ALL, 0, NULL));
+    CHECK(OS_INVALID_ARGUMENT ==
+          CommandGroupInit(&group, children, 3, COMMAND_JOIN_MASK, 1U << 3, NULL));
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, COMMAND_GROUP_MAX_CHILDREN,
+                                         COMMAND_JOIN_MASK, 0xFFFFFFFFU, NULL));
+    CHECK(OS_SUCCESS == CommandGroupInit(&group, children, 3, COMMAND_JOIN_ANY, 1U << 3, NULL));
+
+    printf("test_group: ok\n");
+
+    return 0;
+}
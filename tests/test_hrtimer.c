@@ -0,0 +1,106 @@
+/**
+ * @file test_hrtimer.c
+ *
+ * High resolution timers on the host port's POSIX timer: messages arrive in deadline order
+ * whatever the start order, never before their deadline, a stopped timer never fires, and a
+ * timer started again only fires at its new deadline.
+ */
+
+#include "inc/os.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#define TIMER_COUNT 5
+
+ACTIVE_OBJECT_DECL(receiver, 8)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+static HrTimer_t timers[TIMER_COUNT];
+static Message_t messages[TIMER_COUNT];
+
+//! delay of each timer, in microseconds from the start
+static const uint32_t delays[TIMER_COUNT] = {3000, 1000, 2000, 1500, 500};
+
+//! ids in the order they arrived, and when
+static volatile int received = 0;
+static uint32_t     order[TIMER_COUNT];
+static uint64_t     arrived[TIMER_COUNT];
+
+static void Receiver(Message_t* msg)
+{
+    CHECK(received < TIMER_COUNT);
+
+    order[received] = msg->id;
+    arrived[received] = OSGetTimeUs();
+    received++;
+}
+
+/**
+ * @brief Waits for the AO to receive count messages, or for limit_us to pass
+ *
+ * @param count
+ * @param limit_us
+ */
+static void WaitFor(int count, uint64_t limit_us)
+{
+    uint64_t until = OSGetTimeUs() + limit_us;
+
+    while (received < count && OSGetTimeUs() < until)
+    {
+    }
+}
+
+int main()
+{
+    KernelInit(&os, &callbacks);
+    OSTimebaseInit(OS_PORT_HOST_HZ);
+    AO_INIT(receiver, 1, Receiver, 8, 0);
+
+    for (uint32_t i = 0; i < TIMER_COUNT; i++)
+    {
+        messages[i].id = i;
+        messages[i].msg_size = sizeof(Message_t);
+    }
+
+    uint64_t start = OSGetTimeUs();
+
+    // started out of deadline order, 4 is first on the hardware until stopped
+    for (uint32_t i = 0; i < TIMER_COUNT; i++)
+    {
+        HrTimerStart(&timers[i], &receiver, &messages[i], delays[i]);
+    }
+
+    HrTimerStop(&timers[4]);
+    HrTimerStop(&timers[3]);
+    CHECK(!timers[4].active && !timers[3].active && timers[0].active);
+
+    // started again, 3 moves from the middle to the end
+    HrTimerStart(&timers[3], &receiver, &messages[3], 4000);
+
+    WaitFor(4, 1000000);
+    CHECK(4 == received);
+    CHECK(1 == order[0] && 2 == order[1] && 0 == order[2] && 3 == order[3]);
+
+    // at or after the deadline, never before
+    for (int i = 0; i < 3; i++)
+    {
+        CHECK(arrived[i] - start >= delays[order[i]]);
+    }
+
+    CHECK(arrived[3] - start >= 4000);
+
+    // expired timers are inactive, the stopped one never fired
+    WaitFor(5, 10000);
+    CHECK(4 == received);
+
+    for (int i = 0; i < TIMER_COUNT; i++)
+    {
+        CHECK(!timers[i].active && 0 == timers[i].dropped);
+    }
+
+    printf("test_hrtimer: ok\n");
+
+    return 0;
+}
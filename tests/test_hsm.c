@@ -0,0 +1,174 @@
+/**
+ * @file test_hsm.c
+ *
+ * Hierarchical state machines: entry and exit order of sibling, parent to child, child to
+ * parent and self transitions, transitions whose source isn't active, and nesting deeper than
+ * HSM_MAX_DEPTH.
+ */
+
+#include "inc/hsm.h"
+#include "inc/os_msg.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+//! entries and exits, lower case on entry, upper case on exit
+static char trace[32];
+static int  traced = 0;
+
+//! transition the next message requests, and what HsmTransition returned
+static const HsmTransition_t* next = NULL;
+static OSStatus_t             requested = OS_SUCCESS;
+
+static void Trace(char c)
+{
+    CHECK(traced < (int)sizeof(trace) - 1);
+    trace[traced++] = c;
+}
+
+static void ResetTrace()
+{
+    memset(trace, 0, sizeof(trace));
+    traced = 0;
+}
+
+static bool OnMessage(Hsm_t* hsm, Message_t* msg, void* instance_data)
+{
+    UNUSED(msg);
+    UNUSED(instance_data);
+
+    requested = HsmTransition(hsm, next);
+
+    return true;
+}
+
+#define STATE_HOOKS(c)                                                                             \
+    static void Entry_##c(Hsm_t* hsm, void* instance_data)                                         \
+    {                                                                                              \
+        UNUSED(hsm);                                                                               \
+        UNUSED(instance_data);                                                                     \
+        Trace(#c[0]);                                                                              \
+    }                                                                                              \
+    static void Exit_##c(Hsm_t* hsm, void* instance_data)                                          \
+    {                                                                                              \
+        UNUSED(hsm);                                                                               \
+        UNUSED(instance_data);                                                                     \
+        Trace((char)(#c[0] - 'a' + 'A'));                                                          \
+    }
+
+STATE_HOOKS(r)
+STATE_HOOKS(a)
+STATE_HOOKS(x)
+STATE_HOOKS(y)
+STATE_HOOKS(b)
+
+/*
+ * r
+ * +- a, initial x
+ * |  +- x
+ * |  +- y
+ * +- b
+ */
+static const HsmState_t r, a, x, y, b;
+
+static const HsmState_t r = {NULL, &a, Entry_r, Exit_r, OnMessage};
+static const HsmState_t a = {&r, &x, Entry_a, Exit_a, OnMessage};
+static const HsmState_t x = {&a, NULL, Entry_x, Exit_x, OnMessage};
+static const HsmState_t y = {&a, NULL, Entry_y, Exit_y, OnMessage};
+static const HsmState_t b = {&r, NULL, Entry_b, Exit_b, OnMessage};
+
+//! one deeper than allowed, deep[i] is the parent of deep[i + 1]
+static HsmState_t deep[HSM_MAX_DEPTH + 1];
+
+/**
+ * @brief Dispatches one message requesting transition
+ *
+ * @param hsm
+ * @param transition
+ */
+static void Take(Hsm_t* hsm, const HsmTransition_t* transition)
+{
+    Message_t msg = {1, sizeof(Message_t)};
+
+    ResetTrace();
+    next = transition;
+    CHECK(HsmDispatch(hsm, &msg, NULL));
+}
+
+int main()
+{
+    Hsm_t           hsm;
+    HsmTransition_t x_to_y, a_to_x, x_to_a, a_to_b, b_to_b, y_to_b, deep_to_top;
+
+    CHECK(OS_SUCCESS == HsmTransitionInit(&x_to_y, &x, &y));
+    CHECK(OS_SUCCESS == HsmTransitionInit(&a_to_x, &a, &x));
+    CHECK(OS_SUCCESS == HsmTransitionInit(&x_to_a, &x, &a));
+    CHECK(OS_SUCCESS == HsmTransitionInit(&a_to_b, &a, &b));
+    CHECK(OS_SUCCESS == HsmTransitionInit(&b_to_b, &b, &b));
+    CHECK(OS_SUCCESS == HsmTransitionInit(&y_to_b, &y, &b));
+
+    // ancestors first, then the initial substates
+    HsmInit(&hsm, &r);
+    CHECK(OS_SUCCESS == HsmStart(&hsm, NULL));
+    CHECK(0 == strcmp("rax", trace) && &x == hsm.current);
+
+    // sibling, the parent stays
+    Take(&hsm, &x_to_y);
+    CHECK(0 == strcmp("Xy", trace) && &y == hsm.current);
+
+    // parent to child, defined on the parent while a substate is current: the substate is exited
+    // first, the parent is exited and entered again
+    Take(&hsm, &a_to_x);
+    CHECK(0 == strcmp("YAax", trace) && &x == hsm.current);
+
+    // child to parent, the parent is entered again and its initial substate after it
+    Take(&hsm, &x_to_a);
+    CHECK(0 == strcmp("XAax", trace) && &x == hsm.current);
+
+    // defined on the parent, taken from its substate
+    Take(&hsm, &a_to_b);
+    CHECK(0 == strcmp("XAb", trace) && &b == hsm.current);
+
+    // self, exited and entered again
+    Take(&hsm, &b_to_b);
+    CHECK(0 == strcmp("Bb", trace) && &b == hsm.current);
+
+    // the source isn't active, nothing is exited or entered
+    Take(&hsm, &y_to_b);
+    CHECK(OS_INVALID_ARGUMENT == requested && 0 == traced && &b == hsm.current);
+    CHECK(HsmIsIn(&hsm, &r) && !HsmIsIn(&hsm, &a));
+
+    // nested one level too deep: as a target, a source and an initial state
+    for (int i = 0; i <= HSM_MAX_DEPTH; i++)
+    {
+        deep[i].parent = (i > 0) ? &deep[i - 1] : NULL;
+        deep[i].initial = NULL;
+    }
+
+    CHECK(OS_INVALID_ARGUMENT == HsmTransitionInit(&deep_to_top, &b, &deep[HSM_MAX_DEPTH]));
+    CHECK(OS_INVALID_ARGUMENT == HsmTransitionInit(&deep_to_top, &deep[HSM_MAX_DEPTH], &b));
+    CHECK(OS_SUCCESS == HsmTransitionInit(&deep_to_top, &deep[HSM_MAX_DEPTH - 1], &b));
+
+    ResetTrace();
+    HsmInit(&hsm, &deep[HSM_MAX_DEPTH]);
+    CHECK(OS_INVALID_ARGUMENT == HsmStart(&hsm, NULL));
+    CHECK(NULL == hsm.current);
+
+    // too deep through the initial substates
+    for (int i = 0; i < HSM_MAX_DEPTH; i++)
+    {
+        deep[i].initial = &deep[i + 1];
+    }
+
+    HsmInit(&hsm, &deep[0]);
+    CHECK(OS_INVALID_ARGUMENT == HsmStart(&hsm, NULL));
+    CHECK(OS_INVALID_ARGUMENT == HsmTransitionInit(&deep_to_top, &b, &deep[0]));
+
+    deep[HSM_MAX_DEPTH - 1].initial = NULL;
+    CHECK(OS_SUCCESS == HsmStart(&hsm, NULL));
+    CHECK(&deep[HSM_MAX_DEPTH - 1] == hsm.current);
+
+    printf("test_hsm: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file test_job.c
+ *
+ * Background jobs: jobs take turns in list order, finished and cancelled ones drop out, a slice
+ * runs steps until it is used up or an AO is ready, and the stats count preempted time as the
+ * job's own.
+ */
+
+#include "inc/os_job.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define WORK_MSG_ID 1
+
+ACTIVE_OBJECT_DECL(worker, 2)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+//! job names in the order their steps ran
+static char trace[32];
+static int  traced = 0;
+
+//! AO messages handled
+static int handled = 0;
+
+static void Worker(Message_t* msg)
+{
+    UNUSED(msg);
+    handled++;
+}
+
+static void ResetTrace()
+{
+    memset(trace, 0, sizeof(trace));
+    traced = 0;
+}
+
+static void Spin(uint32_t us)
+{
+    uint64_t until = OSGetCycles() + OSTimeUsToCycles(us);
+
+    while (OSGetCycles() < until)
+    {
+    }
+}
+
+/**
+ * @brief Traces the job's name, its arg, done after total steps
+ *
+ */
+static bool TraceStep(Job_t* job, void* arg)
+{
+    CHECK(traced < (int)sizeof(trace) - 1);
+    trace[traced++] = *(char*)arg;
+
+    return ++job->progress >= job->total;
+}
+
+//! takes 100 us a step
+static bool SpinStep(Job_t* job, void* arg)
+{
+    UNUSED(arg);
+    Spin(100);
+
+    return ++job->progress >= job->total;
+}
+
+//! readies the AO on its third step
+static bool PostStep(Job_t* job, void* arg)
+{
+    Message_t msg = {WORK_MSG_ID, sizeof(Message_t)};
+
+    UNUSED(arg);
+
+    if (3 == ++job->progress)
+    {
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(&worker, &msg));
+    }
+
+    return false;
+}
+
+//! an ISR taking 2 ms preempts the step
+static void SlowIsr()
+{
+    Spin(2000);
+}
+
+static bool PreemptedStep(Job_t* job, void* arg)
+{
+    UNUSED(arg);
+    OSPortHostIsr(SlowIsr);
+
+    return ++job->progress >= job->total;
+}
+
+int main()
+{
+    static char a_name = 'a', b_name = 'b', c_name = 'c';
+    Job_t       a, b, c, spin, post, preempted;
+    JobStats_t  stats;
+
+    KernelInit(&os, &callbacks);
+    OSTimebaseInit(OS_PORT_HOST_HZ);
+    AO_INIT(worker, 1, Worker, 2, 0);
+
+    CHECK(!JobsPending() && !JobRunIdle());
+
+    // a 0 slice runs one step per turn, newest job first, b is done after two steps
+    a.total = 4;
+    b.total = 2;
+    c.total = 4;
+    JobStart(&a, TraceStep, &a_name, 0);
+    JobStart(&b, TraceStep, &b_name, 0);
+    JobStart(&c, TraceStep, &c_name, 0);
+
+    ResetTrace();
+
+    for (int i = 0; i < 6; i++)
+    {
+        CHECK(JobRunIdle());
+    }
+
+    CHECK(0 == strcmp("cbacba", trace) && !b.active);
+
+    // cancelled, c is removed before its next step
+    JobCancel(&c);
+
+    while (JobRunIdle())
+    {
+    }
+
+    CHECK(0 == strcmp("cbacbaaa", trace) && !JobsPending());
+    CHECK(4 == a.steps && 2 == b.steps && 2 == c.steps);
+
+    // a slice runs steps until it is used up
+    spin.total = 1000;
+    JobStart(&spin, SpinStep, NULL, 1000);
+    CHECK(JobRunIdle());
+    CHECK(spin.steps > 1 && spin.cycles >= OSTimeUsToCycles(1000));
+
+    JobGetStats(&spin, &stats);
+    // a total of 1000, per mille is the progress itself
+    CHECK(spin.steps == stats.steps && spin.progress == stats.progress_permille);
+    CHECK(stats.cpu_permille > 500);
+
+    // idle time since JobStart lowers the share
+    Spin(4000);
+    JobGetStats(&spin, &stats);
+    CHECK(stats.cpu_permille < 500);
+    JobCancel(&spin);
+
+    // the slice ends early once an AO is ready, the AO runs before the next turn
+    JobStart(&post, PostStep, NULL, 1000000);
+    CHECK(JobRunIdle());
+    CHECK(3 == post.steps && 0 == handled);
+    SchedulerActivateAO();
+    CHECK(1 == handled);
+    JobCancel(&post);
+
+    // time spent in ISRs preempting a step counts as the job's time
+    preempted.total = 1;
+    JobStart(&preempted, PreemptedStep, NULL, 0);
+    CHECK(JobRunIdle());
+    CHECK(!preempted.active && preempted.cycles >= OSTimeUsToCycles(2000));
+
+    while (JobRunIdle())
+    {
+    }
+
+    CHECK(!JobsPending());
+
+    printf("test_job: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file test_mem.c
+ *
+ * Memory block pool: rejection of stale and made up keys, and threads allocating, writing,
+ * verifying and freeing blocks concurrently. Worth running with -fsanitize=thread too.
+ */
+
+#include "inc/os_mem.h"
+#include "tests/test.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#define THREADS 4
+#define ROUNDS  200000
+
+#define UNITS (OS_MEM_POOL_SIZE / MEMORY_BLOCK_32)
+
+//! thread owning each 32 byte unit, 0 if free, catches overlapping blocks
+static int owner[UNITS];
+
+static int errors = 0;
+
+static void  FillAndFree();
+static void  StaleKeys();
+static void* Worker(void* arg);
+static void* RacingFree(void* arg);
+
+/**
+ * @brief The whole pool in 32 byte blocks, then OS_MEMORY_BLOCK_FULL
+ *
+ */
+static void FillAndFree()
+{
+    uint16_t   keys[UNITS + 1];
+    OSStatus_t status;
+    int        count = 0;
+
+    while (OSMemoryBlockNew(&keys[count], MEMORY_BLOCK_32, &status))
+    {
+        count++;
+    }
+
+    CHECK(UNITS == count);
+    CHECK(OS_MEMORY_BLOCK_FULL == status);
+    CHECK(OS_MEM_KEY_NONE == keys[count]);
+
+    for (int i = 0; i < count; i++)
+    {
+        CHECK(OS_SUCCESS == OSMemoryFreeBlock(keys[i]));
+    }
+}
+
+static void StaleKeys()
+{
+    uint16_t   key;
+    uint16_t   next;
+    OSStatus_t status;
+
+    CHECK(NULL == OSMemoryBlockNew(&key, 48, &status));
+    CHECK(OS_INVALID_ARGUMENT == status && OS_MEM_KEY_NONE == key);
+    CHECK(NULL == OSMemoryBlockGet(OS_MEM_KEY_NONE));
+    CHECK(OS_INVALID_ARGUMENT == OSMemoryFreeBlock(OS_MEM_KEY_NONE));
+
+    uint8_t* block = OSMemoryBlockNew(&key, MEMORY_BLOCK_256, &status);
+
+    CHECK(block && OS_SUCCESS == status && block == OSMemoryBlockGet(key));
+
+    // a key for a block that isn't allocated, and one for a misaligned block
+    CHECK(NULL == OSMemoryBlockGet((uint16_t)(key + UNITS / 2)));
+    CHECK(NULL == OSMemoryBlockGet((uint16_t)(key + 1)));
+
+    // freed: stale for Get, a second free is rejected
+    CHECK(OS_SUCCESS == OSMemoryFreeBlock(key));
+    CHECK(NULL == OSMemoryBlockGet(key));
+    CHECK(OS_INVALID_ARGUMENT == OSMemoryFreeBlock(key));
+
+    // same block again, the old key doesn't alias it
+    CHECK(block == OSMemoryBlockNew(&next, MEMORY_BLOCK_256, &status));
+    CHECK(next != key && NULL == OSMemoryBlockGet(key) && block == OSMemoryBlockGet(next));
+    CHECK(OS_INVALID_ARGUMENT == OSMemoryFreeBlock(key));
+    CHECK(OS_SUCCESS == OSMemoryFreeBlock(next));
+
+    // the generation is 8 bits, a key comes back after 255 frees of its block
+    CHECK(block == OSMemoryBlockNew(&key, MEMORY_BLOCK_256, &status));
+    CHECK(OS_SUCCESS == OSMemoryFreeBlock(key));
+
+    for (int i = 0; i < 254; i++)
+    {
+        CHECK(block == OSMemoryBlockNew(&next, MEMORY_BLOCK_256, &status));
+        CHECK(next != key);
+        CHECK(OS_SUCCESS == OSMemoryFreeBlock(next));
+    }
+
+    CHECK(block == OSMemoryBlockNew(&next, MEMORY_BLOCK_256, &status));
+    CHECK(next == key);
+    CHECK(OS_SUCCESS == OSMemoryFreeBlock(next));
+}
+
+/**
+ * @brief Allocate, write, verify and free blocks of random sizes
+ *
+ * @param arg thread number
+ * @return void*
+ */
+static void* Worker(void* arg)
+{
+    static const BlockSize_t sizes[] = {MEMORY_BLOCK_32, MEMORY_BLOCK_64, MEMORY_BLOCK_128,
+                                        MEMORY_BLOCK_256};
+
+    int      id = (int)(intptr_t)arg + 1;
+    unsigned seed = (unsigned)id * 7919U;
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        BlockSize_t size = sizes[rand_r(&seed) % 4];
+        uint16_t    key;
+        OSStatus_t  status;
+        uint8_t*    block = OSMemoryBlockNew(&key, size, &status);
+
+        if (!block)
+        {
+            if (OS_MEMORY_BLOCK_FULL != status)
+            {
+                __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+            }
+
+            continue;
+        }
+
+        int first = key & 0x3F;
+
+        if (block != OSMemoryBlockGet(key))
+        {
+            __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+        }
+
+        for (unsigned unit = 0; unit < size / MEMORY_BLOCK_32; unit++)
+        {
+            int expected = 0;
+
+            if (!__atomic_compare_exchange_n(&owner[first + unit], &expected, id, false,
+                                             __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            {
+                __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        memset(block, id, size);
+
+        if (0 == round % 3)
+        {
+            sched_yield();
+        }
+
+        for (unsigned i = 0; i < size; i++)
+        {
+            if (id != block[i])
+            {
+                __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+
+        for (unsigned unit = 0; unit < size / MEMORY_BLOCK_32; unit++)
+        {
+            __atomic_store_n(&owner[first + unit], 0, __ATOMIC_SEQ_CST);
+        }
+
+        if (OS_SUCCESS != OSMemoryFreeBlock(key) || OS_INVALID_ARGUMENT != OSMemoryFreeBlock(key))
+        {
+            __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return NULL;
+}
+
+//! key both threads free in a round of RacingFree
+static volatile uint16_t racing_key;
+static int               racing_freed;
+
+static pthread_barrier_t barrier;
+
+/**
+ * @brief Frees the same key as another thread, only one of them may succeed
+ *
+ * @param arg thread number
+ * @return void*
+ */
+static void* RacingFree(void* arg)
+{
+    for (int round = 0; round < ROUNDS / 10; round++)
+    {
+        if (0 == (intptr_t)arg)
+        {
+            OSStatus_t status;
+            uint16_t   key;
+
+            CHECK(OSMemoryBlockNew(&key, MEMORY_BLOCK_64, &status));
+            racing_key = key;
+        }
+
+        pthread_barrier_wait(&barrier);
+
+        if (OS_SUCCESS == OSMemoryFreeBlock(racing_key))
+        {
+            __atomic_add_fetch(&racing_freed, 1, __ATOMIC_RELAXED);
+        }
+
+        pthread_barrier_wait(&barrier);
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    pthread_t threads[THREADS];
+
+    StaleKeys();
+    FillAndFree();
+
+    for (intptr_t i = 0; i < THREADS; i++)
+    {
+        CHECK(0 == pthread_create(&threads[i], NULL, Worker, (void*)i));
+    }
+
+    for (int i = 0; i < THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    CHECK(0 == errors);
+
+    for (int i = 0; i < UNITS; i++)
+    {
+        CHECK(0 == owner[i]);
+    }
+
+    pthread_barrier_init(&barrier, NULL, 2);
+
+    for (intptr_t i = 0; i < 2; i++)
+    {
+        CHECK(0 == pthread_create(&threads[i], NULL, RacingFree, (void*)i));
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    CHECK(ROUNDS / 10 == racing_freed);
+
+    // nothing leaked
+    FillAndFree();
+
+    printf("test_mem: %d threads x %d rounds ok\n", THREADS, ROUNDS);
+
+    return 0;
+}
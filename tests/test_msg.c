@@ -0,0 +1,155 @@
+/**
+ * @file test_msg.c
+ *
+ * Packed queues: an empty queue takes a message as large as its buffer wherever its last
+ * message ended, and messages it can never hold are argument errors, not a full queue.
+ * High watermark: called when the count rises to it, not on every drop-oldest put at it.
+ * Coalescing: a queued message with the same id is replaced where it is, in packed queues only
+ * by one of the same stride.
+ */
+
+#include "inc/os.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define DATA_MSG_ID  1
+#define OTHER_MSG_ID 2
+
+ACTIVE_OBJECT_DECL_PACKED(packed, 32)
+ACTIVE_OBJECT_DECL(ring, 4)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+typedef struct Blob_s
+{
+    Message_t base;
+    uint8_t   payload[32 - sizeof(Message_t)];
+} Blob_t;
+
+static int watermarks = 0;
+
+//! copy of the last message taken
+static Blob_t taken;
+
+static void Packed(Message_t* msg)
+{
+    UNUSED(msg);
+}
+
+static void OnHigh(ActiveObject_t* ao, uint16_t count)
+{
+    CHECK(&ring == ao && 4 == count);
+    watermarks++;
+}
+
+/**
+ * @brief Takes the next message out of the queue the way the scheduler does, copies it to taken
+ *
+ * @param ao
+ * @return uint16_t msg_size of the message
+ */
+static uint16_t Take(ActiveObject_t* ao)
+{
+    Message_t* msg = MsgQueueGet(ao);
+    uint16_t   size = msg->msg_size;
+
+    memcpy(&taken, msg, size);
+    MsgQueueRelease(ao->msg_queue);
+
+    return size;
+}
+
+int main()
+{
+    Blob_t    blob;
+    Message_t msg = {DATA_MSG_ID, sizeof(Message_t)};
+
+    KernelInit(&os, &callbacks);
+    AO_INIT_PACKED(packed, 1, Packed, 32, 0);
+    AO_INIT(ring, 2, Packed, 4, 1);
+
+    memset(&blob, 0, sizeof(blob));
+    blob.base.id = DATA_MSG_ID;
+
+    // leaves head and tail in the middle of the buffer
+    blob.base.msg_size = 12;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&packed, &blob));
+    CHECK(12 == Take(&packed));
+    CHECK(MsgQueueIsEmpty(&packed_message_queue));
+
+    // empty, so the whole buffer is free even though the end has only 20 bytes
+    blob.base.msg_size = 32;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&packed, &blob));
+    CHECK(MSG_Q_FULL == MsgQueuePut(&packed, &blob));
+    CHECK(32 == Take(&packed));
+
+    // too small to be a message, or too large for the buffer, the queue isn't full
+    blob.base.msg_size = sizeof(Message_t) - 1;
+    CHECK(MSG_Q_ERROR == MsgQueuePut(&packed, &blob));
+    blob.base.msg_size = 33;
+    CHECK(MSG_Q_ERROR == MsgQueuePut(&packed, &blob));
+    CHECK(1 == packed_message_queue.dropped);
+    CHECK(MsgQueueIsEmpty(&packed_message_queue));
+
+    // a full drop-oldest queue stays at the watermark, only reaching it counts
+    MsgQueueSetPolicy(&ring_message_queue, MSG_Q_POLICY_DROP_OLDEST);
+    MsgQueueSetHighWatermark(&ring_message_queue, 4, OnHigh);
+
+    for (int i = 0; i < 8; i++)
+    {
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(&ring, &msg));
+    }
+
+    CHECK(1 == watermarks && 4 == ring_message_queue.dropped);
+
+    // below it again, the next put reaches it once more
+    Take(&ring);
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&ring, &msg));
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&ring, &msg));
+    CHECK(2 == watermarks);
+
+    // coalescing keeps the position of the queued message and takes the new value
+    while (!MsgQueueIsEmpty(&ring_message_queue))
+    {
+        Take(&ring);
+    }
+
+    MsgQueueSetPolicy(&ring_message_queue, MSG_Q_POLICY_COALESCE);
+    blob.base.msg_size = 12;
+    blob.payload[0] = 1;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&ring, &blob));
+    blob.base.id = OTHER_MSG_ID;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&ring, &blob));
+    blob.base.id = DATA_MSG_ID;
+    blob.payload[0] = 2;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&ring, &blob));
+    CHECK(2 == MsgQueueCount(&ring_message_queue) && 1 == ring_message_queue.coalesced);
+    Take(&ring);
+    CHECK(DATA_MSG_ID == taken.base.id && 2 == taken.payload[0]);
+    Take(&ring);
+    CHECK(OTHER_MSG_ID == taken.base.id && MsgQueueIsEmpty(&ring_message_queue));
+
+    // packed, a different stride can't take the queued message's place
+    MsgQueueSetPolicy(&packed_message_queue, MSG_Q_POLICY_COALESCE);
+    blob.payload[0] = 3;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&packed, &blob));
+    blob.base.msg_size = 20;
+    blob.payload[0] = 4;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&packed, &blob));
+    CHECK(2 == MsgQueueCount(&packed_message_queue) && 0 == packed_message_queue.coalesced);
+
+    // the same stride can
+    blob.base.msg_size = 11;
+    blob.payload[0] = 5;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&packed, &blob));
+    CHECK(2 == MsgQueueCount(&packed_message_queue) && 1 == packed_message_queue.coalesced);
+    CHECK(11 == Take(&packed) && 5 == taken.payload[0]);
+    CHECK(20 == Take(&packed) && 4 == taken.payload[0]);
+
+    printf("test_msg: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * @file test_overflow.c
+ *
+ * Overflow pool: queues borrow slots once their own buffer is full, up to their borrow_cap and
+ * while the pool has free slots. Messages come out in put order across own and borrowed slots,
+ * slots go back to the pool on release, and drop-oldest rejects while borrowed messages wait.
+ */
+
+#include "inc/os.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+ACTIVE_OBJECT_DECL(first, 2)
+ACTIVE_OBJECT_DECL(second, 2)
+
+MSG_OVERFLOW_POOL_DECL(pool, 4)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+static void Idle(Message_t* msg)
+{
+    UNUSED(msg);
+}
+
+static MessageQueueStatus_t Put(ActiveObject_t* ao, uint32_t id)
+{
+    Message_t msg = {id, sizeof(Message_t)};
+
+    return MsgQueuePut(ao, &msg);
+}
+
+/**
+ * @brief Takes the next message out of the queue the way the scheduler does
+ *
+ * @param ao
+ * @return uint32_t id of the message
+ */
+static uint32_t Take(ActiveObject_t* ao)
+{
+    Message_t* msg = MsgQueueGet(ao);
+    uint32_t   id = msg->id;
+
+    MsgQueueRelease(ao->msg_queue);
+
+    return id;
+}
+
+int main()
+{
+    const MessageOverflowPool_t* stats = MsgOverflowPoolGet();
+
+    KernelInit(&os, &callbacks);
+    AO_INIT(first, 1, Idle, 2, 0);
+    AO_INIT(second, 2, Idle, 2, 1);
+    MsgOverflowPoolInit(pool, 4);
+    MsgQueueSetOverflow(&first_message_queue, 3);
+    MsgQueueSetOverflow(&second_message_queue, 2);
+
+    // two in the own buffer, three borrowed, the cap refuses the sixth without exhausting the pool
+    for (uint32_t id = 1; id <= 5; id++)
+    {
+        CHECK(MSG_Q_SUCCESS == Put(&first, id));
+    }
+
+    CHECK(MSG_Q_FULL == Put(&first, 6));
+    CHECK(3 == first_message_queue.borrowed && 3 == first_message_queue.peak_borrowed);
+    CHECK(3 == stats->in_use && 0 == stats->exhausted && 5 == MsgQueueCount(&first_message_queue));
+
+    // the other queue gets the last slot, then the pool is exhausted below its cap
+    CHECK(MSG_Q_SUCCESS == Put(&second, 1));
+    CHECK(MSG_Q_SUCCESS == Put(&second, 2));
+    CHECK(MSG_Q_SUCCESS == Put(&second, 3));
+    CHECK(MSG_Q_FULL == Put(&second, 4));
+    CHECK(4 == stats->in_use && 4 == stats->peak_in_use && 1 == stats->exhausted);
+    CHECK(1 == second_message_queue.borrowed);
+
+    // own slots first, a put while borrowed messages wait doesn't overtake them
+    CHECK(1 == Take(&first) && 2 == Take(&first));
+    CHECK(MSG_Q_FULL == Put(&first, 7));
+
+    // a borrowed slot is held while its message is handled, then returned
+    Message_t* msg = MsgQueueGet(&first);
+
+    CHECK(3 == msg->id && 3 == first_message_queue.borrowed && 4 == stats->in_use);
+    MsgQueueRelease(&first_message_queue);
+    CHECK(2 == first_message_queue.borrowed && 3 == stats->in_use);
+
+    // the returned slot serves the other queue
+    CHECK(MSG_Q_SUCCESS == Put(&second, 4));
+    CHECK(2 == second_message_queue.borrowed && 4 == stats->in_use);
+
+    CHECK(4 == Take(&first) && 5 == Take(&first));
+    CHECK(MsgQueueIsEmpty(&first_message_queue) && 0 == first_message_queue.borrowed);
+
+    for (uint32_t id = 1; id <= 4; id++)
+    {
+        CHECK(id == Take(&second));
+    }
+
+    CHECK(0 == stats->in_use && 4 == stats->peak_in_use && 3 == first_message_queue.peak_borrowed);
+
+    // drained, the own buffer is used again
+    CHECK(MSG_Q_SUCCESS == Put(&first, 8));
+    CHECK(0 == first_message_queue.borrowed);
+
+    // drop-oldest rejects while borrowed messages wait, nothing queued is lost
+    MsgQueueSetPolicy(&first_message_queue, MSG_Q_POLICY_DROP_OLDEST);
+
+    for (uint32_t id = 9; id <= 12; id++)
+    {
+        CHECK(MSG_Q_SUCCESS == Put(&first, id));
+    }
+
+    uint32_t dropped = first_message_queue.dropped;
+
+    CHECK(MSG_Q_FULL == Put(&first, 13));
+    CHECK(dropped + 1 == first_message_queue.dropped);
+
+    for (uint32_t id = 8; id <= 12; id++)
+    {
+        CHECK(id == Take(&first));
+    }
+
+    CHECK(MsgQueueIsEmpty(&first_message_queue));
+
+    // nothing borrowed and borrowing fails, the oldest message is dropped
+    MsgQueueSetOverflow(&first_message_queue, 0);
+    CHECK(MSG_Q_SUCCESS == Put(&first, 14));
+    CHECK(MSG_Q_SUCCESS == Put(&first, 15));
+    CHECK(MSG_Q_SUCCESS == Put(&first, 16));
+    CHECK(15 == Take(&first) && 16 == Take(&first));
+    CHECK(0 == stats->in_use);
+
+    printf("test_overflow: ok\n");
+
+    return 0;
+}
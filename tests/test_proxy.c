@@ -0,0 +1,293 @@
+/**
+ * @file test_proxy.c
+ *
+ * Proxy link between two kernels, each in its own process, over a socketpair: framing and
+ * resync after garbage, a transport still busy with a frame after it returns, flushes retried
+ * after the deferred call pool was full, and proxies rejected where an AO needs a queue.
+ * Records the receiver can't post safely: larger than a queue slot, or shorter than a header.
+ */
+
+#include "inc/os_defer.h"
+#include "inc/os_proxy.h"
+#include "inc/os_shared.h"
+#include "inc/os_stream.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MOTOR_ID     0
+#define SPEED_MSG_ID 7
+#define STOP_MSG_ID  8
+#define BIG_MSG_ID   9
+#define SHORT_MSG_ID 10
+#define LOST_MSG_ID  11
+#define FRAME_SIZE   64
+
+//! every speed message sent, data 0 to SPEED_COUNT - 1
+#define SPEED_COUNT 18
+
+//! frames sent, see Sender
+#define FRAME_COUNT 10
+
+//! larger than a MessageGeneric_t slot
+typedef struct BigMessage_s
+{
+    Message_t base;
+    uint8_t   payload[OS_MESSAGE_MAX_SIZE + 16];
+} BigMessage_t;
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+/*
+ * Sending node
+ */
+
+static int            sender_fd;
+static ProxyLink_t    proxy_link;
+static uint8_t        link_buffer[2 * FRAME_SIZE];
+static ActiveObject_t remote_motor;
+
+//! transport returns PROXY_TRANSPORT_BUSY, DmaComplete sends the frame later
+static bool           dma = false;
+static const uint8_t* dma_frame = NULL;
+static uint16_t       dma_len = 0;
+
+static uint32_t speed = 0;
+
+static ProxyTransportStatus_t SocketSend(void* context, const uint8_t* frame, uint16_t len)
+{
+    if (dma)
+    {
+        CHECK(NULL == dma_frame);
+
+        dma_frame = frame;
+        dma_len = len;
+
+        return PROXY_TRANSPORT_BUSY;
+    }
+
+    return (len == write(*(int*)context, frame, len)) ? PROXY_TRANSPORT_DONE
+                                                       : PROXY_TRANSPORT_ERROR;
+}
+
+/**
+ * @brief End of the "DMA" transfer, the frame is read only now, so a buffer reused too early
+ *        fails the receiver's CRC
+ *
+ */
+static void DmaComplete()
+{
+    OS_ISR_ENTER(&os);
+
+    const uint8_t* frame = dma_frame;
+
+    dma_frame = NULL;
+    CHECK(dma_len == write(sender_fd, frame, dma_len));
+    ProxyLinkSendComplete(&proxy_link);
+
+    OS_ISR_EXIT(&os);
+}
+
+static void PostSpeed(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        DataMessage_t msg = {{SPEED_MSG_ID, sizeof(DataMessage_t)}, 0, speed++};
+
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(&remote_motor, &msg));
+    }
+}
+
+static void Nothing(void* arg)
+{
+    UNUSED(arg);
+}
+
+static void Rejections()
+{
+    static SharedState_t shared;
+    static uint32_t      value;
+    static Stream_t      stream;
+    static uint8_t       stream_buffer[16];
+
+    SharedStateInit(&shared, &value, sizeof(value));
+    CHECK(OS_SUCCESS == StreamInit(&stream, stream_buffer, sizeof(stream_buffer)));
+
+    CHECK(OS_INVALID_ARGUMENT == ActiveObjectSetFlags(&remote_motor, 1U));
+    CHECK(OS_INVALID_ARGUMENT == SharedStateSubscribe(&shared, &remote_motor, 1U));
+    CHECK(OS_INVALID_ARGUMENT == StreamSetConsumer(&stream, &remote_motor, 1U, 1));
+}
+
+static void Sender()
+{
+    uint8_t junk[] = {1, 2, PROXY_FRAME_SYNC, 0xFF, 0xFF};
+
+    KernelInit(&os, &callbacks);
+    ProxyLinkInit(&proxy_link, SocketSend, &sender_fd, link_buffer, FRAME_SIZE, 3);
+    ProxyCreate(&remote_motor, &proxy_link, MOTOR_ID);
+
+    Rejections();
+
+    // the receiver has to find the first frame after this
+    CHECK(sizeof(junk) == write(sender_fd, junk, sizeof(junk)));
+
+    // synchronous transport, frames of 3, 3, 3 and 1
+    for (int frame = 0; frame < 3; frame++)
+    {
+        PostSpeed(3);
+        SchedulerActivateAO();
+    }
+
+    PostSpeed(1);
+    SchedulerActivateAO();
+    CHECK(4 == proxy_link.frames);
+
+    // busy transport, what's posted meanwhile waits in the other buffer
+    dma = true;
+
+    PostSpeed(3);
+    SchedulerActivateAO();
+    CHECK(proxy_link.sending && NULL != dma_frame);
+
+    PostSpeed(3);
+    SchedulerActivateAO();
+    CHECK(proxy_link.sending && !proxy_link.flush_pending && 5 == proxy_link.frames);
+
+    // completion flushes the second frame, which is sent by the next completion
+    OSPortHostIsr(DmaComplete);
+    CHECK(6 == proxy_link.frames && proxy_link.sending);
+
+    OSPortHostIsr(DmaComplete);
+    CHECK(!proxy_link.sending && NULL == dma_frame);
+
+    dma = false;
+
+    // no room for the flush, the tick retries it
+    for (int i = 0; i < OS_DEFER_POOL_SIZE; i++)
+    {
+        CHECK(OS_SUCCESS == DeferCall(Nothing, NULL, 10));
+    }
+
+    PostSpeed(2);
+    CHECK(!proxy_link.flush_pending);
+
+    SchedulerActivateAO();
+    CHECK(6 == proxy_link.frames);
+
+    OSPortHostTick();
+    CHECK(7 == proxy_link.frames && 0 == proxy_link.dropped);
+
+    // a record too large for the receiver's slots, then one too short to hold its header
+    // followed by one that can't be told apart from garbage anymore
+    BigMessage_t big = {{BIG_MSG_ID, sizeof(BigMessage_t)}, {0}};
+    Message_t    short_msg = {SHORT_MSG_ID, sizeof(Message_t) / 2};
+    Message_t    lost = {LOST_MSG_ID, sizeof(Message_t)};
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&remote_motor, &big));
+    SchedulerActivateAO();
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&remote_motor, &short_msg));
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&remote_motor, &lost));
+    SchedulerActivateAO();
+
+    Message_t stop = {STOP_MSG_ID, sizeof(Message_t)};
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&remote_motor, &stop));
+    SchedulerActivateAO();
+    CHECK(FRAME_COUNT == proxy_link.frames && SPEED_COUNT + 4 == proxy_link.messages);
+}
+
+/*
+ * Receiving node
+ */
+
+ACTIVE_OBJECT_DECL(motor, 8)
+
+static uint32_t speed_count = 0;
+static uint32_t speed_sum = 0;
+static bool     stopped = false;
+
+static void Motor(Message_t* msg)
+{
+    if (SPEED_MSG_ID == msg->id)
+    {
+        // in order, across frames
+        CHECK(speed_count == ((DataMessage_t*)msg)->data);
+
+        speed_count++;
+        speed_sum += ((DataMessage_t*)msg)->data;
+    }
+    else if (STOP_MSG_ID == msg->id)
+    {
+        stopped = true;
+    }
+    else
+    {
+        // big, short and lost are never posted
+        CHECK(false);
+    }
+}
+
+static void Receiver(int fd)
+{
+    static uint8_t  rx_buffer[FRAME_SIZE];
+    ProxyReceiver_t rx;
+    uint8_t         bytes[7];
+    ssize_t         len;
+
+    KernelInit(&os, &callbacks);
+    AO_INIT(motor, 1, Motor, 8, MOTOR_ID);
+
+    ActiveObject_t* aos[] = {&motor};
+
+    ProxyReceiverInit(&rx, aos, 1, rx_buffer, sizeof(rx_buffer));
+
+    // odd sized reads, frames straddle them
+    while ((len = read(fd, bytes, sizeof(bytes))) > 0)
+    {
+        ProxyReceive(&rx, bytes, (uint32_t)len);
+        SchedulerActivateAO();
+    }
+
+    CHECK(FRAME_COUNT == rx.frames);
+    // the junk and the short record, the big one
+    CHECK(2 == rx.crc_errors && 1 == rx.dropped);
+    CHECK(SPEED_COUNT == speed_count && SPEED_COUNT * (SPEED_COUNT - 1) / 2 == speed_sum);
+    CHECK(stopped);
+}
+
+int main()
+{
+    int   fds[2];
+    int   status;
+    pid_t pid;
+
+    CHECK(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    pid = fork();
+    CHECK(pid >= 0);
+
+    if (0 == pid)
+    {
+        close(fds[0]);
+        sender_fd = fds[1];
+
+        Sender();
+
+        close(sender_fd);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    Receiver(fds[0]);
+
+    CHECK(pid == waitpid(pid, &status, 0));
+    CHECK(WIFEXITED(status) && 0 == WEXITSTATUS(status));
+
+    printf("test_proxy: %d messages in %d frames ok\n", SPEED_COUNT + 4, FRAME_COUNT);
+
+    return 0;
+}
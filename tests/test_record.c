@@ -0,0 +1,143 @@
+/**
+ * @file test_record.c
+ *
+ * Record and replay, built with OS_RECORD_ENABLED: a log of posts from outside the AOs, posts
+ * between AOs, a timed event and a put a full queue rejected replays to the same deliveries.
+ */
+
+#include "inc/os_record.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define INPUT_MSG_ID   1
+#define FORWARD_MSG_ID 2
+#define TICK_MSG_ID    3
+#define SINGLE_MSG_ID  4
+
+#define INPUTS 3
+
+STREAM_DECL(record, 1024)
+ACTIVE_OBJECT_DECL(first, 8)
+ACTIVE_OBJECT_DECL(second, 8)
+ACTIVE_OBJECT_DECL(single, 1)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+static int      first_count = 0;
+static int      second_count = 0;
+static int      single_count = 0;
+static uint32_t forward_sum = 0;
+
+static void First(Message_t* msg)
+{
+    DataMessage_t forward = {{FORWARD_MSG_ID, sizeof(DataMessage_t)}, 0,
+                             ((DataMessage_t*)msg)->data};
+
+    first_count++;
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&second, &forward));
+}
+
+static void Second(Message_t* msg)
+{
+    second_count++;
+
+    if (FORWARD_MSG_ID == msg->id)
+    {
+        forward_sum += ((DataMessage_t*)msg)->data;
+    }
+}
+
+static void Single(Message_t* msg)
+{
+    single_count++;
+}
+
+static void Reset()
+{
+    first_count = 0;
+    second_count = 0;
+    single_count = 0;
+    forward_sum = 0;
+}
+
+static void Check()
+{
+    // inputs, their forwards plus the tick, and one of the two singles
+    CHECK(INPUTS == first_count && INPUTS + 1 == second_count && 1 == single_count);
+    CHECK(0 + 1 + 2 == forward_sum);
+}
+
+int main()
+{
+    static uint8_t     log[1024];
+    DataMessage_t      input = {{INPUT_MSG_ID, sizeof(DataMessage_t)}, 0, 0};
+    Message_t          tick = {TICK_MSG_ID, sizeof(Message_t)};
+    Message_t          one = {SINGLE_MSG_ID, sizeof(Message_t)};
+    TimedEventSimple_t event;
+    OSReplay_t         replay;
+
+    KernelInit(&os, &callbacks);
+    OSTimebaseInit(OS_PORT_HOST_HZ);
+    AO_INIT(first, 2, First, 8, 0);
+    AO_INIT(second, 1, Second, 8, 1);
+    AO_INIT(single, 3, Single, 1, 2);
+
+    ActiveObject_t* aos[] = {&first, &second, &single};
+
+    TimedEventSimpleCreate(&event, &second, &tick, 2, TIMED_EVENT_SINGLE_TYPE);
+    SchedulerAddTimedEvent(&event);
+
+    OSRecordStart(&record);
+
+    for (uint32_t i = 0; i < INPUTS; i++)
+    {
+        input.data = i;
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(&first, &input));
+        SchedulerActivateAO();
+        OSPortHostTick();
+    }
+
+    // the second one doesn't fit, it's recorded but never delivered
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&single, &one));
+    CHECK(MSG_Q_FULL == MsgQueuePut(&single, &one));
+    SchedulerActivateAO();
+
+    OSRecordStop();
+    Check();
+    CHECK(0 == OSRecordDropped());
+
+    // inputs, forwards, tick and both singles
+    uint32_t length = StreamRead(&record, log, sizeof(log));
+    uint32_t records = INPUTS * 2 + 1 + 2;
+
+    CHECK(records * sizeof(OSRecordHeader_t) + (INPUTS * 2) * sizeof(DataMessage_t) +
+              3 * sizeof(Message_t) ==
+          length);
+
+    // forwards are sent again by the first AO
+    Reset();
+    OSReplayInit(&replay, log, length, aos, 3, true);
+
+    while (OSReplayNext(&replay))
+    {
+        SchedulerActivateAO();
+    }
+
+    Check();
+    CHECK(OSReplayDone(&replay));
+    CHECK(INPUTS + 2 == replay.injected && INPUTS == replay.skipped && 1 == replay.rejected);
+
+    // recorded speed, everything is due at the end of time
+    Reset();
+    OSReplayInit(&replay, log, length, aos, 3, true);
+    CHECK(INPUTS + 2 == OSReplayUntil(&replay, UINT64_MAX));
+    SchedulerActivateAO();
+    Check();
+
+    printf("test_record: %u records in %u bytes ok\n", records, length);
+
+    return 0;
+}
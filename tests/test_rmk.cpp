@@ -0,0 +1,86 @@
+/**
+ * @file test_rmk.cpp
+ *
+ * C++ layer: typed messages get their id and size, each goes to its on_Message overload, and
+ * anything else to on_Unhandled.
+ */
+
+#include "inc/rmk.hpp"
+
+extern "C" {
+#include "tests/test.h"
+}
+
+#define START_MSG_ID 1
+#define SPEED_MSG_ID 2
+#define OTHER_MSG_ID 3
+
+struct Start : rmk::Message<Start, START_MSG_ID>
+{
+};
+
+struct Speed : rmk::Message<Speed, SPEED_MSG_ID>
+{
+    int16_t rpm;
+};
+
+static int      starts = 0;
+static int32_t  rpm_sum = 0;
+static uint32_t unhandled_id = 0;
+
+struct Controller
+{
+    using Messages = rmk::Messages<Start, Speed>;
+
+    static void on_Message(const Start& msg)
+    {
+        CHECK(sizeof(Start) == msg.msg_size);
+        starts++;
+    }
+
+    static void on_Message(const Speed& msg)
+    {
+        CHECK(sizeof(Speed) == msg.msg_size);
+        rpm_sum += msg.rpm;
+    }
+
+    static void on_Unhandled(Message_t* msg)
+    {
+        unhandled_id = msg->id;
+    }
+};
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+int main()
+{
+    KernelInit(&os, &callbacks);
+
+    rmk::ActiveObject<Controller, 4> controller{1, 0};
+
+    Start start;
+    Speed speed;
+    speed.rpm = 1200;
+
+    CHECK(START_MSG_ID == start.id && SPEED_MSG_ID == speed.id);
+
+    CHECK(MSG_Q_SUCCESS == controller.post(start));
+    CHECK(MSG_Q_SUCCESS == controller.post(speed));
+
+    speed.rpm = -200;
+    CHECK(MSG_Q_SUCCESS == controller.post(speed));
+
+    // through the C API, not in Controller::Messages
+    Message_t other = {OTHER_MSG_ID, sizeof(Message_t)};
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(controller.get(), &other));
+
+    SchedulerActivateAO();
+
+    CHECK(1 == starts && 1000 == rpm_sum && OTHER_MSG_ID == unhandled_id);
+
+    printf("test_rmk: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file test_shared.c
+ *
+ * Seqlock shared state with the writer in an ISR: a timer signal publishes while an AO reads,
+ * preempting its copy. Every value read has to be one whole publish, the one its version says.
+ */
+
+#include "inc/os_shared.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+//! large enough that most ticks land in the middle of a copy
+#define WORDS 4096
+
+#define START_MSG_ID 1
+#define IMU_FLAG     4
+
+//! reads that have to be preempted before the test is conclusive
+#define PREEMPTED_MIN 500
+#define READS_MIN     20000
+#define SECONDS_MAX   20
+
+typedef struct Imu_s
+{
+    uint32_t words[WORDS]; //!< all set to the publish count
+} Imu_t;
+
+SHARED_STATE_DECL(imu, Imu_t)
+ACTIVE_OBJECT_DECL(reader, 4)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+//! publishes so far, written by the ISR only
+static volatile uint32_t published = 0;
+
+static uint32_t reads = 0;
+static uint32_t preempted = 0;
+static uint32_t notifications = 0;
+
+/**
+ * @brief The writer, publishes the next count in every word
+ *
+ */
+static void ImuIsr()
+{
+    static Imu_t next;
+
+    OS_ISR_ENTER(&os);
+
+    for (uint32_t i = 0; i < WORDS; i++)
+    {
+        next.words[i] = published + 1;
+    }
+
+    SharedStatePublish(&imu, &next);
+    published++;
+
+    OS_ISR_EXIT(&os);
+}
+
+static void OnAlarm(int signal)
+{
+    UNUSED(signal);
+    OSPortHostIsr(ImuIsr);
+}
+
+/**
+ * @brief Reads until enough reads were preempted, checking each one
+ *
+ */
+static void ReadAll()
+{
+    static Imu_t value;
+    time_t       end = time(NULL) + SECONDS_MAX;
+
+    while (reads < READS_MIN || preempted < PREEMPTED_MIN)
+    {
+        CHECK(time(NULL) < end);
+
+        uint32_t before = published;
+        uint32_t version = SharedStateRead(&imu, &value);
+
+        // the version read matches the payload, and no word is from another publish
+        CHECK(value.words[0] == version);
+
+        for (uint32_t i = 1; i < WORDS; i++)
+        {
+            CHECK(value.words[i] == version);
+        }
+
+        CHECK(version >= before && version <= published);
+
+        reads++;
+
+        if (published != before)
+        {
+            preempted++;
+        }
+    }
+}
+
+static void Reader(Message_t* msg)
+{
+    if (START_MSG_ID == msg->id)
+    {
+        ReadAll();
+    }
+    else if (OS_EVENT_FLAGS_MSG_ID == msg->id)
+    {
+        CHECK(IMU_FLAG == ((EventFlagsMessage_t*)msg)->flags);
+        notifications++;
+    }
+}
+
+int main()
+{
+    struct sigaction  action;
+    struct itimerval  timer = {{0, 20}, {0, 20}};
+    struct itimerval  off = {{0, 0}, {0, 0}};
+    Message_t         start = {START_MSG_ID, sizeof(Message_t)};
+
+    KernelInit(&os, &callbacks);
+    AO_INIT(reader, 1, Reader, 4, 0);
+    CHECK(OS_SUCCESS == SharedStateSubscribe(&imu, &reader, IMU_FLAG));
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnAlarm;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    CHECK(0 == sigaction(SIGALRM, &action, NULL));
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&reader, &start));
+    CHECK(0 == setitimer(ITIMER_REAL, &timer, NULL));
+
+    SchedulerActivateAO();
+
+    CHECK(0 == setitimer(ITIMER_REAL, &off, NULL));
+
+    // publishes during the reads readied the reader once more, flags coalesce
+    CHECK(notifications >= 1 && notifications < published);
+
+    printf("test_shared: %u reads, %u preempted by %u publishes ok\n", reads, preempted,
+           published);
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file test_stream.c
+ *
+ * Byte streams: sizes that aren't a power of 2 are rejected, data written across the end of the
+ * buffer reads back in order through two windows, short writes count as overruns, and a DMA that
+ * laps the consumer counts an overrun and the reader skips to the oldest data not overwritten.
+ */
+
+#include "inc/os_stream.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#include <string.h>
+
+#define STREAM_SIZE 16
+
+STREAM_DECL(stream, STREAM_SIZE)
+
+//! bytes the simulated DMA wrote, each one is its own count
+static uint32_t dma_count = 0;
+
+/**
+ * @brief Writes count bytes the way a circular DMA does, then commits them
+ *
+ * @param count
+ */
+static void Dma(uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++, dma_count++)
+    {
+        stream.buffer[dma_count % STREAM_SIZE] = (uint8_t)dma_count;
+    }
+
+    StreamDmaCommit(&stream, dma_count % STREAM_SIZE);
+}
+
+/**
+ * @brief Reads len bytes, they must be the counts from first on
+ *
+ * @param first
+ * @param len
+ */
+static void ReadCounts(uint32_t first, uint32_t len)
+{
+    uint8_t data[STREAM_SIZE];
+
+    CHECK(len == StreamRead(&stream, data, len));
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        CHECK((uint8_t)(first + i) == data[i]);
+    }
+}
+
+int main()
+{
+    static uint8_t buffer[STREAM_SIZE];
+    Stream_t       other;
+    uint8_t        data[2 * STREAM_SIZE];
+    uint8_t*       write;
+    const uint8_t* read;
+
+    // index math masks with size - 1
+    CHECK(OS_INVALID_ARGUMENT == StreamInit(&other, buffer, 0));
+    CHECK(OS_INVALID_ARGUMENT == StreamInit(&other, buffer, 12));
+    CHECK(OS_SUCCESS == StreamInit(&other, buffer, STREAM_SIZE));
+
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    // 12 in and out, the next write wraps: 4 bytes at the end, 6 at the start
+    CHECK(12 == StreamWrite(&stream, data, 12));
+    ReadCounts(0, 12);
+    CHECK(10 == StreamWrite(&stream, data, 10));
+    CHECK(10 == StreamAvailable(&stream) && 6 == StreamFree(&stream));
+
+    // the free window starts after the wrapped bytes
+    CHECK(6 == StreamWriteAcquire(&stream, &write) && &stream.buffer[6] == write);
+
+    // read back through the window up to the end, then the one at the start
+    CHECK(4 == StreamReadAcquire(&stream, &read) && &stream.buffer[12] == read);
+    CHECK(0 == memcmp(read, data, 4));
+    StreamReadRelease(&stream, 4);
+    CHECK(6 == StreamReadAcquire(&stream, &read) && stream.buffer == read);
+    CHECK(0 == memcmp(read, &data[4], 6));
+    StreamReadRelease(&stream, 6);
+    CHECK(0 == StreamAvailable(&stream) && 0 == stream.overruns);
+
+    // only as much as is free, the rest is an overrun
+    CHECK(STREAM_SIZE == StreamWrite(&stream, data, 20));
+    CHECK(1 == stream.overruns && 0 == StreamFree(&stream));
+    CHECK(0 == StreamWriteAcquire(&stream, &write));
+    ReadCounts(0, STREAM_SIZE);
+
+    // DMA into the whole buffer from its start
+    CHECK(OS_SUCCESS == StreamInit(&stream, stream.buffer, STREAM_SIZE));
+    Dma(10);
+    CHECK(10 == StreamAvailable(&stream));
+    ReadCounts(0, 4);
+
+    // past the end and around to 4, exactly full, no overrun
+    Dma(10);
+    CHECK(STREAM_SIZE == StreamAvailable(&stream) && 0 == stream.overruns);
+    CHECK(12 == StreamReadAcquire(&stream, &read) && &stream.buffer[4] == read);
+    ReadCounts(4, STREAM_SIZE);
+
+    // around once more and 8 past what the consumer read, the oldest 4 are lost
+    Dma(12);
+    CHECK(0 == stream.overruns);
+    Dma(8);
+    CHECK(1 == stream.overruns && 20 == StreamAvailable(&stream));
+
+    // the reader skips to the oldest byte left, 24 at offset 8
+    CHECK(8 == StreamReadAcquire(&stream, &read) && &stream.buffer[8] == read);
+    CHECK(STREAM_SIZE == StreamAvailable(&stream));
+    ReadCounts(24, STREAM_SIZE);
+    CHECK(0 == StreamAvailable(&stream));
+
+    printf("test_stream: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file test_time.c
+ *
+ * 64-bit timebase: OSGetCycles keeps interrupts disabled when called in a critical section,
+ * and time doesn't go backwards.
+ */
+
+#include "inc/os.h"
+#include "inc/os_time.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+static int isr_runs = 0;
+
+static void Isr()
+{
+    isr_runs++;
+}
+
+int main()
+{
+    KernelInit(&os, &callbacks);
+    OSTimebaseInit(OS_PORT_HOST_HZ);
+
+    // an interrupt raised after OSGetCycles in a critical section still waits for its end
+    DISABLE_INTERRUPTS();
+    OSGetCycles();
+    OSPortHostIsr(Isr);
+    CHECK(0 == isr_runs);
+    ENABLE_INTERRUPTS();
+    CHECK(1 == isr_runs);
+
+    // and outside of one it leaves them enabled
+    OSGetCycles();
+    OSPortHostIsr(Isr);
+    CHECK(2 == isr_runs);
+
+    uint64_t last = OSGetCycles();
+    uint64_t start_us = OSGetTimeUs();
+
+    for (int i = 0; i < 1000000; i++)
+    {
+        uint64_t now = OSGetCycles();
+
+        CHECK(now >= last);
+        last = now;
+
+        if (0 == i % 1000)
+        {
+            OSPortHostTick();
+        }
+    }
+
+    CHECK(OSGetTimeUs() >= start_us && 1000 == OSGetTime());
+
+    printf("test_time: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file test_timed.c
+ *
+ * Timed event slack: an event dispatched early keeps its phase, and a tick whose only dispatch
+ * finds the queue full isn't counted as a wakeup.
+ * Absolute events: on time, late and missed releases, caught up or skipped, keep the phase and
+ * count one overrun per release not dispatched within its period.
+ */
+
+#include "inc/os.h"
+#include "ports/host/port_host.h"
+#include "tests/test.h"
+
+#define START_MSG_ID 1
+#define FAST_MSG_ID  2
+#define SLOW_MSG_ID  3
+#define ONCE_MSG_ID  4
+#define FILL_MSG_ID  5
+#define PHASE_MSG_ID 6
+
+ACTIVE_OBJECT_DECL(ticker, 4)
+ACTIVE_OBJECT_DECL(stuck, 1)
+ACTIVE_OBJECT_DECL(late, 1)
+
+static OS_t             os;
+static OSCallbacksCfg_t callbacks = {NULL, NULL, NULL, NULL};
+
+//! times the slow event was handled at
+static uint32_t slow_times[8];
+static int      slow_count = 0;
+static int      fast_count = 0;
+static int      once_count = 0;
+
+//! times the absolute event was handled at
+static uint32_t phase_times[8];
+static int      phase_count = 0;
+
+static void Ticker(Message_t* msg)
+{
+    if (SLOW_MSG_ID == msg->id)
+    {
+        CHECK(slow_count < 8);
+        slow_times[slow_count++] = OSGetTime();
+    }
+    else if (FAST_MSG_ID == msg->id)
+    {
+        fast_count++;
+    }
+}
+
+static void Stuck(Message_t* msg)
+{
+    static Message_t  fill = {FILL_MSG_ID, sizeof(Message_t)};
+    TimedEventStats_t stats;
+
+    if (START_MSG_ID == msg->id)
+    {
+        // takes the only slot, every put of the due event fails
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(&stuck, &fill));
+
+        for (int i = 0; i < 5; i++)
+        {
+            OSPortHostTick();
+        }
+
+        SchedulerGetTimedEventStats(&stats);
+        CHECK(0 == stats.wakeups && 0 == stats.dispatches);
+    }
+    else if (ONCE_MSG_ID == msg->id)
+    {
+        once_count++;
+    }
+}
+
+static void Late(Message_t* msg)
+{
+    if (PHASE_MSG_ID == msg->id)
+    {
+        CHECK(phase_count < 8);
+        phase_times[phase_count++] = OSGetTime();
+    }
+}
+
+static void Ticks(int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        OSPortHostTick();
+    }
+}
+
+/**
+ * @brief Ticks with the late AO's queue taken by a filler, every dispatch to it fails
+ *
+ * @param n
+ */
+static void Blocked(int n)
+{
+    static Message_t fill = {FILL_MSG_ID, sizeof(Message_t)};
+
+    for (int i = 0; i < n; i++)
+    {
+        CHECK(MSG_Q_SUCCESS == MsgQueuePut(&late, &fill));
+        OSPortHostTick();
+    }
+}
+
+/**
+ * @brief Checks the absolute event's dispatch times since the last call, relative to t0
+ *
+ * @param t0
+ * @param count
+ * @param offsets from t0
+ */
+static void CheckPhase(uint32_t t0, int count, const uint32_t* offsets)
+{
+    CHECK(count == phase_count);
+
+    for (int i = 0; i < count; i++)
+    {
+        CHECK(t0 + offsets[i] == phase_times[i]);
+    }
+
+    phase_count = 0;
+}
+
+int main()
+{
+    static Message_t   start = {START_MSG_ID, sizeof(Message_t)};
+    static Message_t   fast_msg = {FAST_MSG_ID, sizeof(Message_t)};
+    static Message_t   slow_msg = {SLOW_MSG_ID, sizeof(Message_t)};
+    static Message_t   once_msg = {ONCE_MSG_ID, sizeof(Message_t)};
+    TimedEventSimple_t fast;
+    TimedEventSimple_t slow;
+    TimedEventSimple_t once;
+    TimedEventStats_t  stats;
+
+    KernelInit(&os, &callbacks);
+    AO_INIT(ticker, 1, Ticker, 4, 0);
+    AO_INIT(stuck, 2, Stuck, 1, 1);
+
+    // due on the second tick, retried until the queue has room
+    TimedEventSimpleCreate(&once, &stuck, &once_msg, 2, TIMED_EVENT_SINGLE_TYPE);
+    SchedulerAddTimedEvent(&once);
+
+    CHECK(MSG_Q_SUCCESS == MsgQueuePut(&stuck, &start));
+    SchedulerActivateAO();
+
+    OSPortHostTick();
+    SchedulerGetTimedEventStats(&stats);
+    CHECK(1 == once_count && 1 == stats.wakeups && 1 == stats.dispatches);
+
+    // slow is pulled forward to 10 by fast, then due at 24 and 36 on its own
+    TimedEventSimpleCreate(&fast, &ticker, &fast_msg, 10, TIMED_EVENT_PERIODIC_TYPE);
+    TimedEventSimpleCreate(&slow, &ticker, &slow_msg, 12, TIMED_EVENT_PERIODIC_TYPE);
+    TimedEventSetSlack(&slow, 3);
+    SchedulerAddTimedEvent(&fast);
+    SchedulerAddTimedEvent(&slow);
+
+    uint32_t start_time = OSGetTime();
+
+    for (int i = 0; i < 40; i++)
+    {
+        OSPortHostTick();
+    }
+
+    CHECK(4 == fast_count && 3 == slow_count);
+    CHECK(start_time + 10 == slow_times[0]);
+    CHECK(start_time + 24 == slow_times[1]);
+    CHECK(start_time + 36 == slow_times[2]);
+
+    // ticks 10, 20, 24, 30, 36 and 40
+    SchedulerGetTimedEventStats(&stats);
+    CHECK(7 == stats.wakeups && 8 == stats.dispatches && 1 == stats.coalesced);
+
+    TimedEventDisable(&fast);
+    TimedEventDisable(&slow);
+    AO_INIT(late, 3, Late, 1, 2);
+
+    // catching up, released at 10, 20, 30, 40, 50 and 60
+    static Message_t   phase_msg = {PHASE_MSG_ID, sizeof(Message_t)};
+    TimedEventSimple_t phase;
+
+    TimedEventAbsoluteCreate(&phase, &late, &phase_msg, 10, false);
+    SchedulerAddTimedEvent(&phase);
+    start_time = OSGetTime();
+
+    // on time, then 20 is dispatched 11 late and 30 right after it on time
+    Ticks(19);
+    Blocked(11);
+    Ticks(1);
+    CHECK(1 == phase.timing.overruns && 2 == phase_count);
+    Ticks(1);
+    CheckPhase(start_time, 3, (const uint32_t[]){10, 31, 32});
+    CHECK(3 == phase.timing.releases && 1 == phase.timing.overruns);
+    CHECK(11 == phase.timing.jitter_max && 13 == phase.timing.jitter_sum);
+
+    // 40 exactly one period late is one overrun, 50 follows on the next tick, 60 on time
+    Ticks(7);
+    Blocked(10);
+    Ticks(11);
+    CheckPhase(start_time, 3, (const uint32_t[]){50, 51, 60});
+    CHECK(6 == phase.timing.releases && 2 == phase.timing.overruns);
+
+    // skipping, released at 10, 20, 30, ...
+    TimedEventDisable(&phase);
+    Ticks(1);
+    TimedEventAbsoluteCreate(&phase, &late, &phase_msg, 10, true);
+    SchedulerAddTimedEvent(&phase);
+    start_time = OSGetTime();
+
+    // on time, then 20 is missed and the dispatch at 31 is for 30, one late, 40 is on time
+    Ticks(19);
+    Blocked(11);
+    Ticks(10);
+    CheckPhase(start_time, 3, (const uint32_t[]){10, 31, 40});
+    CHECK(3 == phase.timing.releases && 1 == phase.timing.overruns);
+    CHECK(1 == phase.timing.jitter_max && 1 == phase.timing.jitter_sum);
+
+    // 50 exactly one period late, dispatched on time for 60 and counted once
+    Ticks(9);
+    Blocked(10);
+    Ticks(1);
+    CHECK(2 == phase.timing.overruns && 1 == phase.timing.jitter_max);
+
+    // 70 and 80 missed, the dispatch at 95 is for 90, 100 is on time
+    Ticks(9);
+    Blocked(25);
+    Ticks(6);
+    CheckPhase(start_time, 3, (const uint32_t[]){60, 95, 100});
+    CHECK(6 == phase.timing.releases && 4 == phase.timing.overruns);
+    CHECK(5 == phase.timing.jitter_max && 6 == phase.timing.jitter_sum);
+
+    printf("test_timed: ok\n");
+
+    return 0;
+}
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# flash (text + data) and RAM (data + bss) of the kernel library, per object and in total
+# usage: footprint.sh <size tool> <library> [configuration definitions...]
+
+size_tool=$1
+library=$2
+shift 2
+
+echo "configuration: ${*:-defaults}"
+
+"${size_tool}" -t "${library}" | awk '
+    NR == 1 { printf "%-24s %8s %8s\n", "object", "flash", "ram"; next }
+    {
+        name = ($6 == "(TOTALS)") ? "total" : $6
+        printf "%-24s %8d %8d\n", name, $1 + $2, $2 + $3
+    }'
@@ -0,0 +1,388 @@
+#!/usr/bin/env python3
+"""Worst-case response times and queue bounds for rmkernel active objects.
+
+Scheduling model, as implemented in src/os.c:
+
+- ISRs preempt everything.
+- AOs do not preempt each other. PendSV only starts the scheduler from idle. SchedulerAddReady
+  queues a newly ready AO behind the running one, whatever its priority.
+- A running AO drains its whole queue, including messages that arrive while it runs, before the
+  next ready AO starts. The highest priority (lowest number) ready AO goes next.
+- A message keeps its queue slot until its handler returns.
+
+Analysis is non-preemptive fixed priority response time analysis, with messages as jobs:
+
+- Blocking is the longest drain of a lower priority AO, plus one drain of every other AO of the
+  same priority. Equal priorities run in FIFO order, so each of them runs at most once before
+  the AO does. Each counts once, as blocking, not as interference too.
+- A drain starts with the messages queued at that moment and keeps going while its own messages
+  and ISRs arrive. Queued messages are at most a full queue, and at most the messages released
+  during one worst-case response time of the AO, since each of them is still waiting for its
+  handler.
+- Higher priority AOs and the other message streams of the same AO interfere until the
+  message starts.
+- ISRs interfere until it finishes.
+- Messages posted by another AO inherit its worst-case response time as release jitter. Jitters,
+  response times and drains depend on each other, the analysis starts from no jitter and empty
+  queues and is repeated until they all settle.
+
+Times are in microseconds. Handler costs should be measured worst cases, e.g. with OSGetCycles
+around the handler on target. Add the callee's cost to the sender's for direct dispatch
+(ActiveObjectSetDirect), and model deferred calls as AOs at their priority.
+
+Configuration (JSON):
+
+    {
+        "dispatch_overhead_us": 2,
+        "isrs": [
+            {"name": "SysTick", "period_us": 1000, "wcet_us": 5}
+        ],
+        "aos": [
+            {
+                "name": "control", "priority": 1, "queue_depth": 4,
+                "messages": [
+                    {"name": "tick", "period_us": 1000, "jitter_us": 50, "wcet_us": 120},
+                    {"name": "speed", "period_us": 5000, "wcet_us": 30, "sender": "sensor",
+                     "deadline_us": 2000, "burst": 2}
+                ]
+            }
+        ]
+    }
+
+- period_us is the minimum time between releases.
+- burst is the number of messages per release, 1 by default.
+- deadline_us defaults to the period.
+
+Usage: rta.py config.json [--json]. The exit status is 1 if a deadline can be missed or a
+queue can overflow.
+"""
+
+import argparse
+import json
+import sys
+
+#: busy periods longer than this are treated as unbounded (us)
+HORIZON_US = 10_000_000
+
+#: rounds of jitter and backlog propagation between AOs
+MAX_ROUNDS = 1000
+
+
+class Stream:
+    """Messages of one kind posted to an AO."""
+
+    def __init__(self, cfg, overhead):
+        self.name = cfg["name"]
+        self.period = cfg["period_us"]
+        self.cost = cfg["wcet_us"] + overhead
+        self.burst = cfg.get("burst", 1)
+        self.deadline = cfg.get("deadline_us", self.period)
+        self.own_jitter = cfg.get("jitter_us", 0)
+        self.sender = cfg.get("sender")
+        self.jitter = self.own_jitter
+        self.wcrt = None
+
+        if self.period <= 0 or self.burst <= 0:
+            raise ValueError(f"{self.name}: period_us and burst must be positive")
+
+    def releases(self, t):
+        """Messages released in a closed window of length t."""
+        return self.burst * ((t + self.jitter) // self.period + 1)
+
+    def work(self, t):
+        return self.releases(t) * self.cost
+
+    def later_work(self, t):
+        """Work released in a window of length t after an instant already accounted for."""
+        return self.burst * (-(-(t + self.jitter) // self.period)) * self.cost
+
+
+class ActiveObject:
+    def __init__(self, cfg, overhead):
+        self.name = cfg["name"]
+        self.priority = cfg["priority"]
+        self.depth = cfg["queue_depth"]
+        self.streams = [Stream(m, overhead) for m in cfg["messages"]]
+        self.blocking = None
+        self.drain = None
+        self.queue_bound = None
+        # response time the backlog at the start of a drain was released over, None if unbounded
+        self.backlog_window = 0
+
+    def work(self, t):
+        return sum(s.work(t) for s in self.streams)
+
+    def later_work(self, t):
+        return sum(s.later_work(t) for s in self.streams)
+
+    def releases(self, t):
+        return sum(s.releases(t) for s in self.streams)
+
+    def wcrt(self):
+        if any(s.wcrt is None for s in self.streams):
+            return None
+        return max((s.wcrt for s in self.streams), default=0)
+
+
+def isr_load(isrs, t):
+    """ISR execution in a window of length t, ISRs preempt everything."""
+    return sum(-(-(t + i.get("jitter_us", 0)) // i["period_us"]) * i["wcet_us"] for i in isrs)
+
+
+def fixed_point(f, start):
+    """Smallest x >= start with x == f(x), None if it grows past the horizon."""
+    x = start
+    while True:
+        nxt = f(x)
+        if nxt == x:
+            return x
+        if nxt > HORIZON_US:
+            return None
+        x = nxt
+
+
+def drain_bound(ao, isrs):
+    """Longest run of an AO: its backlog plus what arrives while it drains, None if unbounded.
+
+    Two bounds, the smaller one holds:
+
+    - A full queue. Slots are held until handlers return, so nothing more is accepted before
+      the first returns.
+    - Everything released during one response time before the drain, plus what is released
+      while it runs.
+    """
+    backlog = ao.depth * max((s.cost for s in ao.streams), default=0)
+    first = min((s.cost for s in ao.streams), default=0)
+
+    full = fixed_point(
+        lambda x: backlog + ao.later_work(max(0, x - first)) + isr_load(isrs, x), backlog
+    )
+
+    if ao.backlog_window is None:
+        return full
+
+    window = ao.backlog_window
+    released = fixed_point(lambda x: ao.work(window + x) + isr_load(isrs, x), ao.work(window))
+
+    return min((d for d in (full, released) if d is not None), default=None)
+
+
+def analyse_ao(ao, aos, isrs):
+    others = [a for a in aos if a is not ao]
+    interfering = [a for a in others if a.priority < ao.priority]
+    lower = [a.drain for a in others if a.priority > ao.priority]
+    equal = [a.drain for a in others if a.priority == ao.priority]
+
+    # one lower priority AO may be running, equal ones ahead in FIFO order run once each
+    drains = lower + equal
+    ao.blocking = None if None in drains else max(lower, default=0) + sum(equal)
+
+    for s in ao.streams:
+        s.wcrt = None
+
+    if ao.blocking is None:
+        return
+
+    busy = fixed_point(
+        lambda t: ao.blocking + ao.work(t) + sum(a.work(t) for a in interfering) + isr_load(isrs, t),
+        ao.blocking + min((s.cost for s in ao.streams), default=0),
+    )
+
+    if busy is None:
+        return
+
+    for s in ao.streams:
+        siblings = [o for o in ao.streams if o is not s]
+        worst = 0
+
+        for q in range(s.releases(busy)):
+            release = (q // s.burst) * s.period - s.jitter
+
+            start = fixed_point(
+                lambda w: ao.blocking
+                + q * s.cost
+                + sum(o.work(w) for o in siblings)
+                + sum(a.work(w) for a in interfering)
+                + isr_load(isrs, w),
+                ao.blocking + q * s.cost,
+            )
+
+            if start is None:
+                worst = None
+                break
+
+            finish = fixed_point(
+                lambda f: start + s.cost + isr_load(isrs, f) - isr_load(isrs, start),
+                start + s.cost,
+            )
+
+            if finish is None:
+                worst = None
+                break
+
+            worst = max(worst, finish - release)
+
+        s.wcrt = worst
+
+
+def analyse(cfg):
+    overhead = cfg.get("dispatch_overhead_us", 0)
+    isrs = cfg.get("isrs", [])
+    aos = [ActiveObject(a, overhead) for a in cfg["aos"]]
+    by_name = {a.name: a for a in aos}
+
+    for ao in aos:
+        for s in ao.streams:
+            if s.sender is not None and s.sender not in by_name:
+                raise ValueError(f"{ao.name}.{s.name}: unknown sender {s.sender}")
+
+    for ao in aos:
+        ao.drain = drain_bound(ao, isrs)
+
+    for _ in range(MAX_ROUNDS):
+        for ao in aos:
+            analyse_ao(ao, aos, isrs)
+
+        changed = False
+
+        for ao in aos:
+            for s in ao.streams:
+                if s.sender is None:
+                    continue
+
+                sender_wcrt = by_name[s.sender].wcrt()
+                jitter = HORIZON_US if sender_wcrt is None else s.own_jitter + sender_wcrt
+
+                if jitter != s.jitter:
+                    s.jitter = jitter
+                    changed = True
+
+            # longer response times mean more queued when a drain starts
+            if ao.wcrt() != ao.backlog_window:
+                ao.backlog_window = ao.wcrt()
+                changed = True
+
+        if not changed:
+            break
+
+        # longer jitters and backlogs mean longer drains
+        for ao in aos:
+            ao.drain = drain_bound(ao, isrs)
+    else:
+        # didn't settle, nothing is bounded
+        for ao in aos:
+            for s in ao.streams:
+                s.wcrt = None
+
+    # a slot is held from arrival until the handler returns
+    for ao in aos:
+        wcrt = ao.wcrt()
+        ao.queue_bound = None if wcrt is None else ao.releases(wcrt)
+
+    return aos, isrs
+
+
+def problems(aos):
+    found = []
+
+    for ao in aos:
+        if ao.queue_bound is None:
+            found.append(f"{ao.name}: unbounded, queue overflows")
+        elif ao.queue_bound > ao.depth:
+            found.append(f"{ao.name}: up to {ao.queue_bound} messages queued, depth {ao.depth}")
+
+        for s in ao.streams:
+            if s.wcrt is None:
+                found.append(f"{ao.name}.{s.name}: response time unbounded")
+            elif s.wcrt > s.deadline:
+                found.append(f"{ao.name}.{s.name}: response {s.wcrt} us > deadline {s.deadline} us")
+
+    return found
+
+
+def fmt(value):
+    return "-" if value is None else str(value)
+
+
+def report(aos, isrs):
+    isr_u = sum(i["wcet_us"] / i["period_us"] for i in isrs)
+    ao_u = sum(s.burst * s.cost / s.period for a in aos for s in a.streams)
+
+    print(f"load: ISRs {isr_u:.1%}, AOs {ao_u:.1%}, total {isr_u + ao_u:.1%}")
+    print()
+    print(f"{'AO':<16}{'prio':>6}{'depth':>7}{'queue':>7}{'blocking':>10}{'drain':>9}")
+
+    for ao in sorted(aos, key=lambda a: a.priority):
+        print(
+            f"{ao.name:<16}{ao.priority:>6}{ao.depth:>7}{fmt(ao.queue_bound):>7}"
+            f"{fmt(ao.blocking):>10}{fmt(ao.drain):>9}"
+        )
+
+        for s in ao.streams:
+            ok = s.wcrt is not None and s.wcrt <= s.deadline
+            print(
+                f"  {s.name:<14}period {s.period:>7}  jitter {fmt(s.jitter):>7}  "
+                f"cost {s.cost:>6}  deadline {s.deadline:>7}  wcrt {fmt(s.wcrt):>7}  "
+                f"{'ok' if ok else 'MISS'}"
+            )
+
+    found = problems(aos)
+
+    print()
+    print("schedulable" if not found else "\n".join(found))
+
+    return found
+
+
+def report_json(aos):
+    result = {
+        "aos": [
+            {
+                "name": ao.name,
+                "priority": ao.priority,
+                "queue_depth": ao.depth,
+                "queue_bound": ao.queue_bound,
+                "blocking_us": ao.blocking,
+                "drain_us": ao.drain,
+                "messages": [
+                    {
+                        "name": s.name,
+                        "jitter_us": s.jitter,
+                        "cost_us": s.cost,
+                        "deadline_us": s.deadline,
+                        "wcrt_us": s.wcrt,
+                    }
+                    for s in ao.streams
+                ],
+            }
+            for ao in aos
+        ],
+        "problems": problems(aos),
+    }
+
+    print(json.dumps(result, indent=4))
+
+    return result["problems"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="rmkernel response time analysis")
+    parser.add_argument("config", help="JSON description of ISRs, AOs and their messages")
+    parser.add_argument("--json", action="store_true", help="print results as JSON")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        cfg = json.load(f)
+
+    try:
+        aos, isrs = analyse(cfg)
+    except (KeyError, ValueError) as e:
+        sys.exit(f"invalid configuration: {e}")
+
+    found = report_json(aos) if args.json else report(aos, isrs)
+
+    return 1 if found else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
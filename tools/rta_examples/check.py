@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Regression check of rta.py, every example config against its expected report.
+
+The expected report of name.json is name.out, the text report and the exit status. After an
+intended change of the analysis, check the new reports by hand and rewrite them with --update.
+
+Usage: check.py [--update]. The exit status is 1 if a report differs.
+"""
+
+import argparse
+import difflib
+import pathlib
+import subprocess
+import sys
+
+HERE = pathlib.Path(__file__).resolve().parent
+RTA = HERE.parent / "rta.py"
+
+
+def report(config):
+    result = subprocess.run(
+        [sys.executable, str(RTA), str(config)], capture_output=True, text=True, check=False
+    )
+    return f"{result.stdout}{result.stderr}exit status {result.returncode}\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="rta.py regression check")
+    parser.add_argument("--update", action="store_true", help="rewrite the expected reports")
+    args = parser.parse_args()
+
+    failed = 0
+
+    for config in sorted(HERE.glob("*.json")):
+        expected_path = config.with_suffix(".out")
+        actual = report(config)
+
+        if args.update:
+            expected_path.write_text(actual)
+            continue
+
+        expected = expected_path.read_text() if expected_path.exists() else ""
+
+        if actual != expected:
+            failed += 1
+            sys.stdout.writelines(
+                difflib.unified_diff(
+                    expected.splitlines(True), actual.splitlines(True), str(expected_path), "rta.py"
+                )
+            )
+        else:
+            print(f"{config.name}: ok")
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())